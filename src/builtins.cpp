@@ -1,7 +1,9 @@
 #include "builtins.h"
 
 #include <cmath>
+#include <format>
 #include <iostream>
+#include <unordered_map>
 
 #include "error.h"
 #include "eval_env.h"
@@ -13,36 +15,36 @@
         throw ValueError("Cannot " #op " a non-numeric value.", var->getLocation()); \
     }
 
-#define BUILTIN_BINARY_OP(name, op, displayName, initValue, returnTy)                     \
-    ValuePtr name(const std::vector<ValuePtr>& params) {                                  \
-        CHECK_EMPTY_PARAMS(displayName)                                                   \
-        const size_t numParams = params.size();                                           \
-        if (numParams == 1) {                                                             \
-            BUILTIN_NUMBER_CHECK(params[0], subtract);                                    \
-            return ValuePool::instance()->makeValue<returnTy>(initValue op *              \
-                                                              params[0]->asNumber());     \
-        }                                                                                 \
-        if (numParams == 2) {                                                             \
-            BUILTIN_NUMBER_CHECK(params[0], subtract);                                    \
-            BUILTIN_NUMBER_CHECK(params[1], subtract);                                    \
-            return ValuePool::instance()->makeValue<returnTy>(*params[0]->asNumber() op * \
-                                                              params[1]->asNumber());     \
-        }                                                                                 \
-        std::optional<Location> loc;                                                      \
-        if (params.empty()) {                                                             \
-            loc = params[0]->getLocation();                                               \
-        }                                                                                 \
-        throw ValueError(#displayName " requires exactly one or two arguments.", loc);    \
+#define BUILTIN_BINARY_OP(name, op, displayName, initValue, returnTy)                      \
+    ValuePtr name(const std::vector<ValuePtr>& params) {                                   \
+        CHECK_EMPTY_PARAMS(displayName)                                                    \
+        const size_t numParams = params.size();                                            \
+        if (numParams == 1) {                                                              \
+            BUILTIN_NUMBER_CHECK(params[0], subtract);                                     \
+            return ValuePool::instance()->makeValue<returnTy>(Number{initValue} op         \
+                                                              numberOf(params[0]));        \
+        }                                                                                  \
+        if (numParams == 2) {                                                              \
+            BUILTIN_NUMBER_CHECK(params[0], subtract);                                     \
+            BUILTIN_NUMBER_CHECK(params[1], subtract);                                     \
+            return ValuePool::instance()->makeValue<returnTy>(numberOf(params[0]) op       \
+                                                              numberOf(params[1]));        \
+        }                                                                                  \
+        std::optional<Location> loc;                                                       \
+        if (params.empty()) {                                                              \
+            loc = params[0]->getLocation();                                                \
+        }                                                                                  \
+        throw ValueError(#displayName " requires exactly one or two arguments.", loc);     \
     }
 
 #define BUILTIN_MULTI_OP(name, op, displayName, initValue) \
     ValuePtr name(const std::vector<ValuePtr>& params) {   \
-        double result = initValue;                         \
+        Number result = initValue;                         \
         for (const auto& i : params) {                     \
             BUILTIN_NUMBER_CHECK(i, displayName);          \
-            result = result op * i->asNumber();            \
+            result = result op numberOf(i);                \
         }                                                  \
-        return LISP_NUM(result);                           \
+        return LISP_NUM(std::move(result));                \
     }
 
 #define BUILT_IN_IS_TYPE(name, type)                               \
@@ -51,22 +53,53 @@
         return LISP_BOOL(params[0]->getType() == ValueType::type); \
     }
 
+static const Number& numberOf(const ValuePtr& value) {
+    return static_cast<NumericValue*>(value)->getNumber();
+}
+
 const std::set LITERAL_TYPE = {ValueType::BOOLEAN, ValueType::NUMBER, ValueType::NIL,
                                ValueType::SYMBOL};
 
-BUILTIN_MULTI_OP(builtins::add, +, add, 0.0)
-BUILTIN_MULTI_OP(builtins::mul, *, multiply, 1.0)
-
-BUILTIN_BINARY_OP(builtins::sub, -, Subtraction, 0.0, NumericValue)
-BUILTIN_BINARY_OP(builtins::div, /, Division, 1.0, NumericValue)
-BUILTIN_BINARY_OP(builtins::eq, ==, Equality, 0.0, BooleanValue)
-BUILTIN_BINARY_OP(builtins::lt, <, Less than, 0.0, BooleanValue)
-BUILTIN_BINARY_OP(builtins::gt, >, Greater than, 0.0, BooleanValue)
-BUILTIN_BINARY_OP(builtins::le, <=, Greater than, 0.0, BooleanValue)
-BUILTIN_BINARY_OP(builtins::ge, >=, Greater than, 0.0, BooleanValue)
+BUILTIN_MULTI_OP(builtins::add, +, add, 0)
+BUILTIN_MULTI_OP(builtins::mul, *, multiply, 1)
+
+BUILTIN_BINARY_OP(builtins::sub, -, Subtraction, 0, NumericValue)
+BUILTIN_BINARY_OP(builtins::div, /, Division, 1, NumericValue)
+BUILTIN_BINARY_OP(builtins::eq, ==, Equality, 0, BooleanValue)
+BUILTIN_BINARY_OP(builtins::lt, <, Less than, 0, BooleanValue)
+BUILTIN_BINARY_OP(builtins::gt, >, Greater than, 0, BooleanValue)
+BUILTIN_BINARY_OP(builtins::le, <=, Greater than, 0, BooleanValue)
+BUILTIN_BINARY_OP(builtins::ge, >=, Greater than, 0, BooleanValue)
+
+#define NUMERIC_KERNEL(name, kind, op, initValue)                                          \
+    {&builtins::name,                                                                      \
+     {builtins::NumericKernel::Kind::kind, initValue,                                      \
+      [](const Number& a, const Number& b) -> Number { return Number{a op b}; }}}
+
+const std::unordered_map<BuiltinFuncType*, builtins::NumericKernel> NUMERIC_KERNELS = {
+    NUMERIC_KERNEL(add, MULTI, +, 0),   NUMERIC_KERNEL(mul, MULTI, *, 1),
+    NUMERIC_KERNEL(sub, BINARY, -, 0),  NUMERIC_KERNEL(div, BINARY, /, 1),
+    NUMERIC_KERNEL(eq, COMPARE, ==, 0), NUMERIC_KERNEL(lt, COMPARE, <, 0),
+    NUMERIC_KERNEL(gt, COMPARE, >, 0),  NUMERIC_KERNEL(le, COMPARE, <=, 0),
+    NUMERIC_KERNEL(ge, COMPARE, >=, 0),
+};
+
+#undef NUMERIC_KERNEL
+
+const builtins::NumericKernel* builtins::numericKernel(BuiltinFuncType* func) {
+    const auto it = NUMERIC_KERNELS.find(func);
+    return it == NUMERIC_KERNELS.end() ? nullptr : &it->second;
+}
 
 ValuePtr builtins::apply(const std::vector<ValuePtr>& params) {
     CHECK_PARAM_NUM(apply, 2);
+    if (params[0]->getType() == ValueType::LAMBDA) {
+        // forwards the list to a rest parameter as is
+        return static_cast<LambdaValue*>(params[0])->applyList(params[1]);
+    }
+    if (params[1]->getType() == ValueType::NIL) {
+        return EvalEnv::apply(params[0], {});
+    }
     CHECK_TYPE(params[1], PAIR, apply, list);
     auto param = dynamic_cast<PairValue*>(params[1]);
     auto paramList = param->toVector();
@@ -74,6 +107,16 @@ ValuePtr builtins::apply(const std::vector<ValuePtr>& params) {
     return EvalEnv::apply(params[0], paramList);
 }
 
+ValuePtr builtins::values(const std::vector<ValuePtr>& params) {
+    return MultipleValues::of(params);
+}
+
+ValuePtr builtins::callWithValues(const std::vector<ValuePtr>& params) {
+    CHECK_PARAM_NUM(call-with-values, 2);
+    const auto produced = EvalEnv::apply(params[0], {});
+    return EvalEnv::apply(params[1], MultipleValues::unpack(produced));
+}
+
 ValuePtr builtins::display(const std::vector<ValuePtr>& params) {
     for (const auto& i : params) {
         std::cout << i->toString() << ' ';
@@ -167,8 +210,7 @@ ValuePtr builtins::integer(const std::vector<ValuePtr>& params) {
     if (!params[0]->isNumber()) {
         return LISP_BOOL(false);
     }
-    const double value = *params[0]->asNumber();
-    return LISP_BOOL(std::abs(static_cast<int>(value) - value) < 1e-7);
+    return LISP_BOOL(numberOf(params[0]).isInteger());
 }
 
 ValuePtr builtins::isList(const std::vector<ValuePtr>& params) {
@@ -224,6 +266,20 @@ ValuePtr builtins::cons(const std::vector<ValuePtr>& params) {
     return LISP_PAIR(params[0], params[1]);
 }
 
+ValuePtr builtins::setCar(const std::vector<ValuePtr>& params) {
+    CHECK_PARAM_NUM(set-car!, 2);
+    CHECK_TYPE(params[0], PAIR, set-car!, pair);
+    static_cast<PairValue*>(params[0])->setCar(params[1]);
+    return LISP_NIL;
+}
+
+ValuePtr builtins::setCdr(const std::vector<ValuePtr>& params) {
+    CHECK_PARAM_NUM(set-cdr!, 2);
+    CHECK_TYPE(params[0], PAIR, set-cdr!, pair);
+    static_cast<PairValue*>(params[0])->setCdr(params[1]);
+    return LISP_NIL;
+}
+
 ValuePtr builtins::makeList(const std::vector<ValuePtr>& params) {
     if (params.empty()) {
         return LISP_NIL;
@@ -231,69 +287,124 @@ ValuePtr builtins::makeList(const std::vector<ValuePtr>& params) {
     return LISP_PAIR(PairValue::fromVector(params));
 }
 
-ValuePtr builtins::map(const std::vector<ValuePtr>& params) {
-    CHECK_PARAM_NUM(map, 2);
-    CHECK_TYPE(params[1], PAIR, map, list);
-    const auto& func = params[0];
-    const auto arg = dynamic_cast<PairValue*>(params[1]);
-    auto vec = arg->toVector();
-    CHECK_LIST(vec, map);
-    std::vector<ValuePtr> result;
-    for (const auto& i : vec) {
-        result.push_back(EvalEnv::apply(func, {i}));
+/**
+ * Check that the source of a list pipeline is a proper list, before any function is applied
+ */
+static void checkPipelineSource(const ValuePtr& list, const char* name, const bool allowEmpty) {
+    if (list->getType() == ValueType::NIL && allowEmpty) {
+        return;
+    }
+    if (list->getType() != ValueType::PAIR) {
+        throw TypeError(std::format("{} requires a list as its argument", name),
+                        list->getLocation());
+    }
+    auto current = list;
+    while (current->getType() == ValueType::PAIR) {
+        current = static_cast<PairValue*>(current)->getCdr();
+    }
+    if (current->getType() != ValueType::NIL) {
+        throw ValueError(std::format("{} requires a list as its argument", name),
+                         static_cast<PairValue*>(list)->getCar()->getLocation());
     }
-    return LISP_PAIR(PairValue::fromVector(result));
 }
 
-ValuePtr builtins::filter(const std::vector<ValuePtr>& params) {
-    CHECK_PARAM_NUM(filter, 2);
-    CHECK_TYPE(params[1], PAIR, filter, list);
-    const auto& func = params[0];
-    const auto arg = dynamic_cast<PairValue*>(params[1]);
-    auto vec = arg->toVector();
-    CHECK_LIST(vec, filter);
-    std::vector<ValuePtr> result;
-    for (const auto& i : vec) {
-        auto res = EvalEnv::apply(func, {i});
-        if (res->getType() != ValueType::BOOLEAN) {
-            throw ValueError("filter function must return a boolean value", std::nullopt);
+ValuePtr builtins::runPipeline(const std::vector<PipelineStage>& stages, const ValuePtr& list,
+                               const ValuePtr& reducer) {
+    using Kind = PipelineStage::Kind;
+    const char* sourceName = "reduce";
+    if (!stages.empty()) {
+        sourceName = stages.front().kind == Kind::MAP ? "map" : "filter";
+    }
+    checkPipelineSource(list, sourceName, !stages.empty());
+
+    ListBuilder builder;
+    std::vector<ValuePtr> reduced;
+    for (auto current = list; current->getType() == ValueType::PAIR;) {
+        const auto pair = static_cast<PairValue*>(current);
+        current = pair->getCdr();
+
+        auto value = pair->getCar();
+        bool keep = true;
+        for (const auto& [kind, func] : stages) {
+            if (kind == Kind::MAP) {
+                value = EvalEnv::applyForValue(func, {value});
+                continue;
+            }
+            const auto res = EvalEnv::apply(func, {value});
+            if (res->getType() != ValueType::BOOLEAN) {
+                throw ValueError("filter function must return a boolean value", std::nullopt);
+            }
+            if (!static_cast<BooleanValue*>(res)->getValue()) {
+                keep = false;
+                break;
+            }
         }
-        if (dynamic_cast<BooleanValue*>(res)->getValue()) {
-            result.push_back(i);
+        if (!keep) {
+            continue;
+        }
+        if (reducer == nullptr) {
+            builder.push(value);
+        } else {
+            reduced.push_back(value);
         }
     }
-    return LISP_PAIR(PairValue::fromVector(result));
+
+    if (reducer == nullptr) {
+        return builder.build();
+    }
+    if (reduced.empty()) {
+        throw TypeError("reduce requires a list as its argument", std::nullopt);
+    }
+    // `reduce` folds from the right: (f x1 (f x2 ... (f xn-1 xn)))
+    auto result = reduced.back();
+    for (auto it = reduced.rbegin() + 1; it != reduced.rend(); ++it) {
+        result = EvalEnv::applyForValue(reducer, {*it, result});
+    }
+    return result;
+}
+
+ValuePtr builtins::map(const std::vector<ValuePtr>& params) {
+    CHECK_PARAM_NUM(map, 2);
+    return runPipeline({{PipelineStage::Kind::MAP, params[0]}}, params[1], nullptr);
+}
+
+ValuePtr builtins::filter(const std::vector<ValuePtr>& params) {
+    CHECK_PARAM_NUM(filter, 2);
+    return runPipeline({{PipelineStage::Kind::FILTER, params[0]}}, params[1], nullptr);
 }
 
 ValuePtr builtins::reduce(const std::vector<ValuePtr>& params) {
     CHECK_PARAM_NUM(reduce, 2);
-    CHECK_TYPE(params[1], PAIR, reduce, list);
-    const auto& func = params[0];
-    const auto arg = dynamic_cast<PairValue*>(params[1]);
-    auto cdr = arg->getCdr();
-    if (cdr->getType() == ValueType::NIL) {
-        return arg->getCar();
-    }
-    return EvalEnv::apply(func, {arg->getCar(), reduce({func, cdr})});
+    return runPipeline({}, params[1], params[0]);
 }
 
 ValuePtr builtins::abs(const std::vector<ValuePtr>& params) {
     CHECK_PARAM_NUM(abs, 1);
     CHECK_TYPE(params[0], NUMBER, abs, number);
-    return LISP_NUM(std::abs(*params[0]->asNumber()));
+    return LISP_NUM(numberOf(params[0]).abs());
 }
 
 ValuePtr builtins::expt(const std::vector<ValuePtr>& params) {
     CHECK_PARAM_NUM(expt, 2);
     CHECK_TYPE(params[0], NUMBER, expt, number);
     CHECK_TYPE(params[1], NUMBER, expt, number);
-    return LISP_NUM(std::pow(*params[0]->asNumber(), *params[1]->asNumber()));
+    return LISP_NUM(numberOf(params[0]).expt(numberOf(params[1])));
+}
+
+/**
+ * Whether the operands of an integer division are both exact, otherwise it is done on doubles
+ */
+static bool exactDivision(const std::vector<ValuePtr>& params) {
+    return numberOf(params[0]).isExact() && numberOf(params[1]).isExact();
 }
 
 ValuePtr builtins::quotient(const std::vector<ValuePtr>& params) {
     CHECK_PARAM_NUM(quotient, 2);
     CHECK_TYPE(params[0], NUMBER, quotient, number);
     CHECK_TYPE(params[1], NUMBER, quotient, number);
+    if (exactDivision(params)) {
+        return LISP_NUM(Number::quotient(numberOf(params[0]), numberOf(params[1])));
+    }
     const double res = *params[0]->asNumber() / *params[1]->asNumber();
     return LISP_NUM(res >= 0 ? std::floor(res) : std::ceil(res));
 }
@@ -302,6 +413,9 @@ ValuePtr builtins::modulo(const std::vector<ValuePtr>& params) {
     CHECK_PARAM_NUM(modulo, 2);
     CHECK_TYPE(params[0], NUMBER, modulo, number);
     CHECK_TYPE(params[1], NUMBER, modulo, number);
+    if (exactDivision(params)) {
+        return LISP_NUM(Number::modulo(numberOf(params[0]), numberOf(params[1])));
+    }
     const double a = *params[0]->asNumber();
     const double b = *params[1]->asNumber();
     if (a * b > 0) {
@@ -314,11 +428,42 @@ ValuePtr builtins::remainder(const std::vector<ValuePtr>& params) {
     CHECK_PARAM_NUM(remainder, 2);
     CHECK_TYPE(params[0], NUMBER, remainder, number);
     CHECK_TYPE(params[1], NUMBER, remainder, number);
+    if (exactDivision(params)) {
+        return LISP_NUM(Number::remainder(numberOf(params[0]), numberOf(params[1])));
+    }
     const double a = *params[0]->asNumber();
     const double b = *params[1]->asNumber();
     return LISP_NUM(a - std::trunc(a / b) * b);
 }
 
+ValuePtr builtins::isExact(const std::vector<ValuePtr>& params) {
+    CHECK_PARAM_NUM(exact?, 1);
+    CHECK_TYPE(params[0], NUMBER, exact?, number);
+    return LISP_BOOL(numberOf(params[0]).isExact());
+}
+
+ValuePtr builtins::isInexact(const std::vector<ValuePtr>& params) {
+    CHECK_PARAM_NUM(inexact?, 1);
+    CHECK_TYPE(params[0], NUMBER, inexact?, number);
+    return LISP_BOOL(!numberOf(params[0]).isExact());
+}
+
+ValuePtr builtins::exact(const std::vector<ValuePtr>& params) {
+    CHECK_PARAM_NUM(exact, 1);
+    CHECK_TYPE(params[0], NUMBER, exact, number);
+    try {
+        return LISP_NUM(numberOf(params[0]).toExact());
+    } catch (const ValueError& e) {
+        throw ValueError(e.what(), params[0]->getLocation());
+    }
+}
+
+ValuePtr builtins::inexact(const std::vector<ValuePtr>& params) {
+    CHECK_PARAM_NUM(inexact, 1);
+    CHECK_TYPE(params[0], NUMBER, inexact, number);
+    return LISP_NUM(numberOf(params[0]).toInexact());
+}
+
 ValuePtr builtins::loceq(const std::vector<ValuePtr>& params) {
     CHECK_PARAM_NUM(loceq, 2);
     if (params[0]->getType() != params[1]->getType()) {
@@ -348,17 +493,26 @@ ValuePtr builtins::logicalNot(const std::vector<ValuePtr>& params) {
 ValuePtr builtins::even(const std::vector<ValuePtr>& params) {
     CHECK_PARAM_NUM(even, 1);
     CHECK_TYPE(params[0], NUMBER, even, number);
-    return LISP_BOOL(std::abs(std::remainder(*params[0]->asNumber(), 2)) <= 1e-7);
+    const auto& number = numberOf(params[0]);
+    return LISP_BOOL(number.isInteger() && !number.isOdd());
 }
 
 ValuePtr builtins::odd(const std::vector<ValuePtr>& params) {
     CHECK_PARAM_NUM(odd, 1);
     CHECK_TYPE(params[0], NUMBER, odd, number);
-    return LISP_BOOL(std::abs(std::abs(std::remainder(*params[0]->asNumber(), 2)) - 1) <= 1e-7);
+    const auto& number = numberOf(params[0]);
+    return LISP_BOOL(number.isInteger() && number.isOdd());
 }
 
 ValuePtr builtins::zero(const std::vector<ValuePtr>& params) {
     CHECK_PARAM_NUM(zero, 1);
     CHECK_TYPE(params[0], NUMBER, zero, number);
-    return LISP_BOOL(std::abs(*params[0]->asNumber()) <= 1e-7);
+    return LISP_BOOL(numberOf(params[0]).isZero());
+}
+
+ValuePtr builtins::gensym(const std::vector<ValuePtr>& params) {
+    CHECK_PARAM_NUM(gensym, 0);
+    // `#:` cannot start a symbol in the source
+    static size_t counter = 0;
+    return ValuePool::instance()->makeValue<SymbolValue>(std::format("#:g{}", ++counter));
 }
@@ -7,6 +7,54 @@
 
 namespace builtins {
 
+/**
+ * Unboxed implementation of an arithmetic builtin. The evaluator uses it to fold nested arithmetic
+ * on plain numbers, so intermediate results never become NumericValue objects.
+ */
+struct NumericKernel {
+    enum class Kind {
+        MULTI,    // any number of operands folded from `init`, e.g. `+`
+        BINARY,   // one or two operands, the single operand form is `init op x`, e.g. `-`
+        COMPARE,  // like BINARY, but the result is a boolean, e.g. `<`
+    };
+
+    Kind kind;
+    Number init;
+    Number (*op)(const Number&, const Number&);  // comparisons return 1 or 0
+};
+
+/**
+ * Find the unboxed kernel of a builtin procedure
+ * @param func builtin procedure
+ * @return the kernel, or nullptr if the builtin is not a plain arithmetic operation
+ */
+const NumericKernel* numericKernel(BuiltinFuncType* func);
+
+/**
+ * A `map` or `filter` step of a fused list pipeline
+ */
+struct PipelineStage {
+    enum class Kind {
+        MAP,
+        FILTER,
+    };
+
+    Kind kind;
+    ValuePtr func;
+};
+
+/**
+ * Run a chain of `map`/`filter` steps over a list in a single pass, without building the
+ * intermediate lists
+ * @param stages steps to apply to every element, innermost first
+ * @param list the source list
+ * @param reducer if not nullptr, reduce the surviving elements like `reduce` does, otherwise
+ * collect them into a new list
+ * @return the result of the outermost call of the chain
+ */
+ValuePtr runPipeline(const std::vector<PipelineStage>& stages, const ValuePtr& list,
+                     const ValuePtr& reducer);
+
 ValuePtr add(const std::vector<ValuePtr>& params);
 
 ValuePtr sub(const std::vector<ValuePtr>& params);
@@ -27,6 +75,10 @@ ValuePtr ge(const std::vector<ValuePtr>& params);
 
 ValuePtr apply(const std::vector<ValuePtr>& params);
 
+ValuePtr values(const std::vector<ValuePtr>& params);
+
+ValuePtr callWithValues(const std::vector<ValuePtr>& params);
+
 ValuePtr display(const std::vector<ValuePtr>& params);
 
 ValuePtr displayln(const std::vector<ValuePtr>& params);
@@ -69,6 +121,10 @@ ValuePtr append(const std::vector<ValuePtr>& params);
 
 ValuePtr cons(const std::vector<ValuePtr>& params);
 
+ValuePtr setCar(const std::vector<ValuePtr>& params);
+
+ValuePtr setCdr(const std::vector<ValuePtr>& params);
+
 ValuePtr makeList(const std::vector<ValuePtr>& params);
 
 ValuePtr map(const std::vector<ValuePtr>& params);
@@ -87,6 +143,15 @@ ValuePtr modulo(const std::vector<ValuePtr>& params);
 
 ValuePtr remainder(const std::vector<ValuePtr>& params);
 
+ValuePtr isExact(const std::vector<ValuePtr>& params);
+
+ValuePtr isInexact(const std::vector<ValuePtr>& params);
+
+/// The exact integer equal to an integral number
+ValuePtr exact(const std::vector<ValuePtr>& params);
+
+ValuePtr inexact(const std::vector<ValuePtr>& params);
+
 /// Whether two values are stored at the same memory location
 ValuePtr loceq(const std::vector<ValuePtr>& params);
 
@@ -101,6 +166,9 @@ ValuePtr odd(const std::vector<ValuePtr>& params);
 
 ValuePtr zero(const std::vector<ValuePtr>& params);
 
+/// A fresh symbol that cannot clash with any symbol in the source, for use in macros
+ValuePtr gensym(const std::vector<ValuePtr>& params);
+
 }  // namespace builtins
 
 #endif  // BUILTINS_H
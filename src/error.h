@@ -34,6 +34,7 @@ LISP_ERROR(ValueError)
 LISP_ERROR(UnimplementedError)
 LISP_ERROR(InternalError)
 LISP_ERROR(TypeError)
+LISP_ERROR(RecursionError)
 
 #undef LISP_ERROR
 
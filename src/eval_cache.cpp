@@ -0,0 +1,169 @@
+#include "eval_cache.h"
+
+#include <functional>
+#include <iterator>
+
+#include "eval_env.h"
+#include "pool.h"
+#include "utils.h"
+
+/**
+ * Whether a form is `(quote ...)` or `(quasiquote ...)`. These return parts of their operand as
+ * they are, so the operand is data rather than code: it is neither copied nor shared between
+ * forms, but compared by identity.
+ */
+static bool isQuoted(const Value* value) {
+    if (value->getType() != ValueType::PAIR) {
+        return false;
+    }
+    const auto name = static_cast<const PairValue*>(value)->getCar()->asSymbolName();
+    return name == "quote" || name == "quasiquote";
+}
+
+/**
+ * Atoms that behave the same whichever of several equal ones is used. Other values, including
+ * strings, which `eq?` tells apart, are the same code only if they are the same object.
+ */
+static bool isValueAtom(const ValueType type) {
+    return type == ValueType::BOOLEAN || type == ValueType::NUMBER || type == ValueType::NIL ||
+           type == ValueType::SYMBOL;
+}
+
+/**
+ * Hash a form, counting its pairs on the way
+ */
+static size_t hashCode(const Value* value, size_t& pairs) {
+    if (isQuoted(value)) {
+        pairs++;
+        return std::hash<const Value*>{}(value);
+    }
+    size_t hash = 17;
+    while (value->getType() == ValueType::PAIR) {
+        const auto pair = static_cast<const PairValue*>(value);
+        pairs++;
+        hash = hash * 31 + hashCode(pair->getCar(), pairs);
+        value = pair->getCdr();
+    }
+    size_t atom = 0;
+    switch (value->getType()) {
+        case ValueType::BOOLEAN:
+            atom = static_cast<const BooleanValue*>(value)->getValue();
+            break;
+        case ValueType::NUMBER:
+            atom = std::hash<double>{}(static_cast<const NumericValue*>(value)->getValue());
+            break;
+        case ValueType::STRING:
+            atom = std::hash<std::string>{}(static_cast<const StringValue*>(value)->getValue());
+            break;
+        case ValueType::SYMBOL:
+            atom = std::hash<std::string>{}(static_cast<const SymbolValue*>(value)->getValue());
+            break;
+        case ValueType::NIL:
+            break;
+        default:
+            atom = std::hash<const Value*>{}(value);
+    }
+    return hash * 31 + atom + static_cast<size_t>(value->getType());
+}
+
+/**
+ * Whether two forms are the same code. Unlike `equals`, procedures embedded in the forms are
+ * compared by identity, as closures with the same code may capture different environments.
+ */
+static bool sameCode(const Value* a, const Value* b) {
+    if (isQuoted(a) || isQuoted(b)) {
+        return a == b;
+    }
+    while (a->getType() == ValueType::PAIR) {
+        if (b->getType() != ValueType::PAIR) {
+            return false;
+        }
+        const auto pairA = static_cast<const PairValue*>(a);
+        const auto pairB = static_cast<const PairValue*>(b);
+        if (!sameCode(pairA->getCar(), pairB->getCar())) {
+            return false;
+        }
+        a = pairA->getCdr();
+        b = pairB->getCdr();
+    }
+    if (a == b) {
+        return true;
+    }
+    if (a->getType() != b->getType() || !isValueAtom(a->getType())) {
+        return false;
+    }
+    return a->equals(const_cast<Value*>(b));
+}
+
+/**
+ * Copy the pairs of a form, except for quoted data
+ */
+static ValuePtr copyCode(ValuePtr value) {
+    if (value->getType() != ValueType::PAIR || isQuoted(value)) {
+        return value;
+    }
+    const auto head = static_cast<PairValue*>(value);
+    const auto result = LISP_PAIR(copyCode(head->getCar()), LISP_NIL, head->getLocation());
+    auto tail = result;
+    for (value = head->getCdr(); value->getType() == ValueType::PAIR;
+         value = static_cast<PairValue*>(value)->getCdr()) {
+        const auto pair = static_cast<PairValue*>(value);
+        const auto copy = LISP_PAIR(copyCode(pair->getCar()), LISP_NIL, pair->getLocation());
+        tail->setCdr(copy);
+        tail = copy;
+    }
+    tail->setCdr(value);
+    return result;
+}
+
+ValuePtr EvalCache::canonical(ValuePtr form) {
+    if (form->getType() != ValueType::PAIR) {
+        return form;
+    }
+    // what was derived from the code may depend on global definitions
+    if (epoch != EvalEnv::redefinitions) {
+        clear();
+        epoch = EvalEnv::redefinitions;
+    }
+
+    size_t pairs = 0;
+    const size_t hash = hashCode(form, pairs);
+    if (pairs > MAX_PAIRS) {
+        return form;
+    }
+    const auto [begin, end] = index.equal_range(hash);
+    for (auto it = begin; it != end; ++it) {
+        if (sameCode(it->second->code, form)) {
+            entries.splice(entries.begin(), entries, it->second);
+            return it->second->code;
+        }
+    }
+
+    entries.push_front({hash, copyCode(form)});
+    index.emplace(hash, entries.begin());
+    if (entries.size() > CAPACITY) {
+        const auto last = std::prev(entries.end());
+        const auto [first, stop] = index.equal_range(last->hash);
+        for (auto it = first; it != stop; ++it) {
+            if (it->second == last) {
+                index.erase(it);
+                break;
+            }
+        }
+        entries.pop_back();
+    }
+    return entries.front().code;
+}
+
+void EvalCache::clear() {
+    entries.clear();
+    index.clear();
+}
+
+std::vector<ValuePtr> EvalCache::values() const {
+    std::vector<ValuePtr> result;
+    for (const auto& entry : entries) {
+        result.push_back(entry.code);
+    }
+    return result;
+}
@@ -0,0 +1,50 @@
+#ifndef EVAL_CACHE_H
+#define EVAL_CACHE_H
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "value.h"
+
+/**
+ * Canonical copies of the forms passed to `eval`, in a bounded LRU keyed by structural hash.
+ *
+ * What the evaluator derives from code, like macro expansions, is cached in the code itself. Data
+ * built anew for every `eval` would lose it each time, so `eval` runs a canonical copy of the form
+ * instead, shared by all structurally identical forms. The copies are private to the cache, so
+ * mutating the original data cannot affect them. Quoted data and strings are not copied: `quote`
+ * must return its operand itself, so forms only share a copy if they quote the same objects.
+ */
+class EvalCache {
+    struct Entry {
+        size_t hash;
+        ValuePtr code;
+    };
+
+    std::list<Entry> entries;  // most recently used first
+    std::unordered_multimap<size_t, std::list<Entry>::iterator> index;
+    size_t epoch = 0;
+
+public:
+    static constexpr size_t CAPACITY = 256;
+
+    /// Forms with more pairs than this are evaluated as is
+    static constexpr size_t MAX_PAIRS = 10000;
+
+    /**
+     * Find the canonical copy of a form
+     * @param form the form to evaluate
+     * @return a form structurally identical to `form`
+     */
+    ValuePtr canonical(ValuePtr form);
+
+    void clear();
+
+    /**
+     * Values kept alive by the cache, used by the garbage collector
+     */
+    std::vector<ValuePtr> values() const;
+};
+
+#endif  // EVAL_CACHE_H
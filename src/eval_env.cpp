@@ -10,6 +10,7 @@
 #include "builtins.h"
 #include "error.h"
 #include "forms.h"
+#include "macro.h"
 #include "pool.h"
 #include "utils.h"
 #include "value.h"
@@ -29,6 +30,8 @@ void EvalEnv::addBuiltins() {
         BUILTIN_PAIR(le, <=),
         BUILTIN_PAIR(ge, >=),
         BUILTIN_PAIR(apply, apply),
+        BUILTIN_PAIR(values, values),
+        BUILTIN_PAIR(callWithValues, call-with-values),
         BUILTIN_PAIR(display, display),
         BUILTIN_PAIR(print, print),
         BUILTIN_PAIR(exit, exit),
@@ -50,6 +53,8 @@ void EvalEnv::addBuiltins() {
         BUILTIN_PAIR(procedure, procedure?),
         BUILTIN_PAIR(append, append),
         BUILTIN_PAIR(cons, cons),
+        BUILTIN_PAIR(setCar, set-car!),
+        BUILTIN_PAIR(setCdr, set-cdr!),
         BUILTIN_PAIR(makeList, list),
         BUILTIN_PAIR(map, map),
         BUILTIN_PAIR(filter, filter),
@@ -59,12 +64,19 @@ void EvalEnv::addBuiltins() {
         BUILTIN_PAIR(quotient, quotient),
         BUILTIN_PAIR(modulo, modulo),
         BUILTIN_PAIR(remainder, remainder),
+        BUILTIN_PAIR(isExact, exact?),
+        BUILTIN_PAIR(isInexact, inexact?),
+        BUILTIN_PAIR(exact, exact),
+        BUILTIN_PAIR(inexact, inexact),
+        BUILTIN_PAIR(exact, inexact->exact),
+        BUILTIN_PAIR(inexact, exact->inexact),
         BUILTIN_PAIR(loceq, eq?),
         BUILTIN_PAIR(dataeq, equal?),
         BUILTIN_PAIR(logicalNot, not),
         BUILTIN_PAIR(even, even?),
         BUILTIN_PAIR(odd, odd?),
         BUILTIN_PAIR(zero, zero?),
+        BUILTIN_PAIR(gensym, gensym),
     };
 
     for (const auto& i : builtins) {
@@ -78,71 +90,191 @@ EvalEnv::EvalEnv() {
 
 EvalEnv::EvalEnv(const EvalEnv* parent) : parent{parent} {}
 
-ValuePtr EvalEnv::eval(ValuePtr expr) {
-    using OptStr = std::optional<std::string>;
-
-    const auto ty = expr->getType();
-    if (SELF_EVAL_VALUES.contains(ty)) {  // self-evaluating types
-        return expr;
+/**
+ * Split the arguments of a call to a two argument builtin
+ * @return the two argument expressions, or std::nullopt if there are not exactly two of them
+ */
+static std::optional<std::pair<ValuePtr, ValuePtr>> twoArguments(const ValuePtr& argList) {
+    if (argList->getType() != ValueType::PAIR) {
+        return std::nullopt;
     }
-    if (ty == ValueType::NIL) {  // nil
-        throw ValueError("Cannot evaluate an empty list (nil value)", expr->getLocation());
+    const auto first = static_cast<PairValue*>(argList);
+    if (first->getCdr()->getType() != ValueType::PAIR) {
+        return std::nullopt;
     }
-    if (ty == ValueType::SYMBOL) {  // symbol, lookup in symbol table
-        const auto symbolName =
-            expr->asSymbolName()
-                .or_else([&] -> OptStr {
-                    throw ValueError("Expected symbol, found keyword", expr->getLocation());
-                })
-                .value_or("");
-        try {
-            return this->lookupBinding(symbolName);
-        } catch (const ValueError& e) {
-            if (e.location()) {
-                throw;
-            }
-            throw ValueError(std::format("Undefined variable: {}", symbolName),
+    const auto second = static_cast<PairValue*>(first->getCdr());
+    if (second->getCdr()->getType() != ValueType::NIL) {
+        return std::nullopt;
+    }
+    return std::pair{first->getCar(), second->getCar()};
+}
+
+/**
+ * Find the special form a list starting with `head` invokes
+ * @return the special form, or nullptr if the list is a function call
+ */
+static SpecialFormType* specialFormOf(const Value* head) {
+    if (head->getType() != ValueType::SYMBOL) {
+        return nullptr;
+    }
+    return static_cast<const SymbolValue*>(head)->getForm();
+}
+
+ValuePtr EvalEnv::eval(ValuePtr expr) {
+    if (depth >= maxDepth) {
+        throw RecursionError(std::format("Maximum recursion depth ({}) exceeded", maxDepth),
                              expr->getLocation());
-        }
     }
-    if (ty == ValueType::PAIR) {  // pair
-        const auto pair = dynamic_cast<PairValue*>(expr);
-        const std::vector<ValuePtr> values = pair->toVector();
+    if (nativeStackExhausted()) {
+        throw RecursionError(
+            std::format("Recursion too deep for the native stack at depth {}", depth),
+            expr->getLocation());
+    }
+    depth++;
+    struct DepthGuard {
+        ~DepthGuard() {
+            depth--;
+        }
+    } guard;
+
+    EvalEnv* env = this;
+    // `(cons x rest)` is evaluated in destination-passing style: the cell is allocated before
+    // `rest` is evaluated, and its cdr (the hole) is filled in with whatever `rest` evaluates to.
+    // Recursive list builders thus run in a loop instead of growing the C++ stack.
+    ValuePtr head = nullptr;
+    PairValue* hole = nullptr;
+    // The call frame entered by this invocation. Other frames that are `env` during the loop may
+    // still be in use by an outer invocation and are never reused.
+    EvalEnv* frame = nullptr;
+    const auto finish = [&](const ValuePtr result) {
+        if (hole == nullptr) {
+            return result;
+        }
+        hole->setCdr(MultipleValues::single(result));
+        return head;
+    };
 
-        if (values.empty()) {
-            throw ValueError("Cannot evaluate an empty list", expr->getLocation());
+    while (true) {
+        if (expr->getType() != ValueType::PAIR) {
+            return finish(env->evalAtom(expr));
         }
+        const auto pair = static_cast<PairValue*>(expr);
 
-        auto first = values[0];
+        auto first = pair->getCar();
         if (first->getType() != ValueType::SYMBOL) {
-            first = this->eval(first);
+            first = env->eval(first);
         }
 
-        const auto firstName = first->asSymbolName();
         // Check if it's a special form
-        if (firstName && SPECIAL_FORMS.contains(firstName.value())) {
-            const auto form = SPECIAL_FORMS.at(firstName.value());
-            auto params = std::vector(values.begin() + 1, values.end());
-            removeTrailingNil(params);
-            return form(params, this);
+        if (const auto form = specialFormOf(first)) {
+            std::vector<ValuePtr> params;
+            if (pair->getCdr()->getType() == ValueType::PAIR) {
+                params = static_cast<PairValue*>(pair->getCdr())->toVector();
+                removeTrailingNil(params);
+            }
+            const auto result = form(params, env);
+            if (result.tailEnv == nullptr) {
+                return finish(result.value);
+            }
+            expr = result.value;
+            env = result.tailEnv;
+            continue;
         }
 
-        // It's a function call
-        const auto proc = this->eval(first);
-        const std::vector<ValuePtr> args = this->evalList(pair->getCdr());
-        return apply(proc, args);
+        // It's a function call, or a macro use standing for the code it expands to. Calling a
+        // procedure by its name does not let it escape.
+        const auto proc = first->getType() == ValueType::SYMBOL ? env->lookupVariable(first)
+                                                                : env->eval(first);
+        if (proc->getType() == ValueType::MACRO) {
+            expr = static_cast<MacroValue*>(proc)->expandCached(pair);
+            continue;
+        }
+        if (proc->getType() == ValueType::BUILTIN) {
+            const auto builtin = static_cast<BuiltinProcValue*>(proc);
+            if (const auto result = env->evalNumericCall(builtin, pair->getCdr())) {
+                return finish(*result);
+            }
+            if (const auto result = env->evalPipelineCall(builtin, pair->getCdr())) {
+                return finish(*result);
+            }
+            if (builtin->getFunc() == &builtins::cons) {
+                const auto args = twoArguments(pair->getCdr());
+                if (args && args->second->getType() == ValueType::PAIR) {
+                    const auto car = MultipleValues::single(env->eval(args->first));
+                    const auto cell = LISP_PAIR(car, LISP_NIL);
+                    if (hole == nullptr) {
+                        head = cell;
+                    } else {
+                        hole->setCdr(cell);
+                    }
+                    hole = cell;
+                    expr = args->second;
+                    continue;
+                }
+            }
+        }
+        const std::vector<ValuePtr> args = env->evalList(pair->getCdr());
+        if (proc->getType() != ValueType::LAMBDA) {
+            return finish(apply(proc, args));
+        }
+
+        // a lambda call, its last body expression is evaluated in place (proper tail call). A self
+        // tail call from the frame entered by this loop reuses that frame if nothing captured it,
+        // so a loop written as tail recursion runs without allocating environments.
+        const auto lambda = static_cast<LambdaValue*>(proc);
+        EvalEnv* bodyEnv;
+        if (env == frame && frame->owner == lambda && !frame->captured) {
+            lambda->rebind(frame, args);
+            bodyEnv = frame;
+        } else {
+            bodyEnv = lambda->bind(args);
+        }
+        frame = bodyEnv;
+        const auto& body = lambda->getBody();
+        if (body.empty()) {
+            return finish(LISP_NIL);
+        }
+        for (const auto& bodyExpr : std::views::take(body, body.size() - 1)) {
+            bodyEnv->eval(bodyExpr);
+        }
+        expr = body.back();
+        env = bodyEnv;
     }
-    if (ty == ValueType::BUILTIN || ty == ValueType::LAMBDA) {
+}
+
+ValuePtr EvalEnv::evalAtom(ValuePtr expr) {
+    const auto ty = expr->getType();
+    if (SELF_EVAL_VALUES.contains(ty)) {  // self-evaluating types
+        return expr;
+    }
+    if (ty == ValueType::NIL) {  // nil
+        throw ValueError("Cannot evaluate an empty list (nil value)", expr->getLocation());
+    }
+    if (ty == ValueType::SYMBOL) {  // symbol, lookup in symbol table
+        const auto value = lookupVariable(expr);
+        // a procedure used as a value may outlive the frames it refers to
+        if (value->getType() == ValueType::LAMBDA) {
+            static_cast<LambdaValue*>(value)->escape();
+        }
+        return value;
+    }
+    if (ty == ValueType::BUILTIN || ty == ValueType::LAMBDA || ty == ValueType::MACRO ||
+        ty == ValueType::RECORD_TYPE || ty == ValueType::RECORD) {
         return expr;
     }
     throw InternalError("This is a bug, not your fault, please report it", std::nullopt);
 }
 
 void EvalEnv::reset() {
+    redefinitions++;
     symbolTable.clear();
     addBuiltins();
 }
 
+ValuePtr EvalEnv::applyForValue(const ValuePtr& proc, const std::vector<ValuePtr>& args) {
+    return MultipleValues::single(apply(proc, args));
+}
+
 ValuePtr EvalEnv::apply(const ValuePtr& proc, const std::vector<ValuePtr>& args) {
     if (proc->getType() == ValueType::BUILTIN) {
         const auto builtin = dynamic_cast<BuiltinProcValue*>(proc);
@@ -166,22 +298,63 @@ std::vector<ValuePtr> EvalEnv::evalList(const ValuePtr& expr) {
     }
     auto vector = pair->toVector();
     removeTrailingNil(vector);
-    std::ranges::transform(vector, std::back_inserter(result),
-                           [this](const ValuePtr& v) { return this->eval(v); });
+    std::ranges::transform(vector, std::back_inserter(result), [this](const ValuePtr& v) {
+        return MultipleValues::single(this->eval(v));
+    });
     return result;
 }
 
 std::optional<ValuePtr> EvalEnv::addVariable(const std::string& name, const ValuePtr& value) {
+    MultipleValues::single(value);
+    if (const auto slot = findSlot(name)) {
+        const auto old = std::exchange(*slot, value);
+        if (old == nullptr) {
+            return std::nullopt;
+        }
+        return old;
+    }
     if (symbolTable.contains(name)) {
+        if (parent == nullptr) {
+            redefinitions++;
+        }
         auto old = symbolTable[name];
         symbolTable[name] = value;
         return old;
     }
+    // a new global macro may change the analysis of code calling it
+    if (parent == nullptr && value->getType() == ValueType::MACRO) {
+        redefinitions++;
+    }
     symbolTable[name] = value;
     return std::nullopt;
 }
 
+bool EvalEnv::assignVariable(const std::string& name, const ValuePtr& value) {
+    MultipleValues::single(value);
+    for (auto env = this; env != nullptr; env = const_cast<EvalEnv*>(env->parent)) {
+        ValuePtr* binding = env->findSlot(name);
+        if (binding == nullptr || *binding == nullptr) {
+            const auto it = env->symbolTable.find(name);
+            binding = it == env->symbolTable.end() ? nullptr : &it->second;
+        }
+        if (binding == nullptr) {
+            continue;
+        }
+        // analysis only depends on which macros globals are bound to
+        if (env->parent == nullptr && (value->getType() == ValueType::MACRO ||
+                                       (*binding)->getType() == ValueType::MACRO)) {
+            redefinitions++;
+        }
+        *binding = value;
+        return true;
+    }
+    return false;
+}
+
 bool EvalEnv::removeVariable(const std::string& name) {
+    if (const auto slot = findSlot(name)) {
+        return std::exchange(*slot, nullptr) != nullptr;
+    }
     if (symbolTable.contains(name)) {
         symbolTable.erase(name);
         return true;
@@ -189,19 +362,262 @@ bool EvalEnv::removeVariable(const std::string& name) {
     return false;
 }
 
+void EvalEnv::capture() const {
+    // the parents of a captured environment are captured already
+    for (auto env = this; env != nullptr && !env->captured; env = env->parent) {
+        env->captured = true;
+    }
+}
+
+bool EvalEnv::isCaptured() const {
+    return captured;
+}
+
+void EvalEnv::reserveSlots(std::shared_ptr<const std::vector<std::string>> names) {
+    slots.assign(names->size(), nullptr);
+    layout = std::move(names);
+}
+
+void EvalEnv::setSlot(const size_t index, const ValuePtr value) {
+    slots[index] = MultipleValues::single(value);
+}
+
+ValuePtr* EvalEnv::findSlot(const std::string& name) {
+    if (layout == nullptr) {
+        return nullptr;
+    }
+    // frames are small, a linear scan beats hashing the name
+    for (size_t i = 0; i < slots.size(); i++) {
+        if ((*layout)[i] == name) {
+            return &slots[i];
+        }
+    }
+    return nullptr;
+}
+
 std::vector<std::string> EvalEnv::variables() const {
-    return std::views::keys(symbolTable) | std::ranges::to<std::vector>();
+    auto result = std::views::keys(symbolTable) | std::ranges::to<std::vector>();
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (slots[i] != nullptr) {
+            result.push_back((*layout)[i]);
+        }
+    }
+    return result;
+}
+
+/**
+ * Check whether a call of an arithmetic builtin can be folded without boxing, i.e. whether the
+ * arguments form a proper list of a length the builtin accepts.
+ */
+static bool canFold(const builtins::NumericKernel& kernel, const ValuePtr& argList) {
+    size_t count = 0;
+    auto current = argList;
+    while (current->getType() == ValueType::PAIR) {
+        count++;
+        current = static_cast<PairValue*>(current)->getCdr();
+    }
+    if (current->getType() != ValueType::NIL) {
+        return false;
+    }
+    return kernel.kind == builtins::NumericKernel::Kind::MULTI || count == 1 || count == 2;
+}
+
+std::optional<ValuePtr> EvalEnv::evalNumericCall(const BuiltinProcValue* proc,
+                                                 const ValuePtr& argList) {
+    const auto kernel = builtins::numericKernel(proc->getFunc());
+    if (kernel == nullptr || !canFold(*kernel, argList)) {
+        return std::nullopt;
+    }
+    auto result = foldNumeric(proc, *kernel, argList);
+    if (kernel->kind == builtins::NumericKernel::Kind::COMPARE) {
+        return LISP_BOOL(!result.isZero());
+    }
+    return LISP_NUM(std::move(result));
+}
+
+Number EvalEnv::foldNumeric(const BuiltinProcValue* proc, const builtins::NumericKernel& kernel,
+                            const ValuePtr& argList) {
+    using Kind = builtins::NumericKernel::Kind;
+    Number result = kernel.init;
+    Number first = 0;
+    size_t index = 0;
+    for (auto current = argList; current->getType() == ValueType::PAIR; index++) {
+        const auto pair = static_cast<PairValue*>(current);
+        current = pair->getCdr();
+
+        ValuePtr boxed = nullptr;
+        const auto operand = evalOperand(pair->getCar(), boxed);
+        if (!operand) {
+            // A non-numeric operand. Evaluate the remaining operands like a generic call does and
+            // let the builtin report the error itself.
+            std::vector<ValuePtr> args;
+            if (index > 0) {
+                args.push_back(LISP_NUM(kernel.kind == Kind::MULTI ? result : first));
+            }
+            args.push_back(boxed);
+            std::ranges::copy(evalList(current), std::back_inserter(args));
+            proc->apply(args);
+            throw InternalError("Arithmetic builtin accepted a non-numeric value", std::nullopt);
+        }
+
+        if (kernel.kind == Kind::MULTI) {
+            result = kernel.op(result, *operand);
+        } else if (index == 0) {
+            first = *operand;
+            result = kernel.op(kernel.init, first);
+        } else {
+            result = kernel.op(first, *operand);
+        }
+    }
+    return result;
+}
+
+/**
+ * The number a value holds, or nullopt if it is not a number
+ */
+static std::optional<Number> unboxed(const ValuePtr& value) {
+    if (value->getType() != ValueType::NUMBER) {
+        return std::nullopt;
+    }
+    return static_cast<NumericValue*>(value)->getNumber();
+}
+
+std::optional<Number> EvalEnv::evalOperand(const ValuePtr& expr, ValuePtr& boxed) {
+    if (expr->getType() == ValueType::NUMBER) {
+        return static_cast<NumericValue*>(expr)->getNumber();
+    }
+    // nested arithmetic is folded in place, its result never leaves the C++ stack
+    if (expr->getType() == ValueType::PAIR) {
+        const auto pair = static_cast<PairValue*>(expr);
+        const auto head = pair->getCar();
+        if (head->getType() == ValueType::SYMBOL && !specialFormOf(head)) {
+            const auto proc = lookupVariable(head);
+            if (proc->getType() == ValueType::BUILTIN) {
+                const auto builtin = static_cast<BuiltinProcValue*>(proc);
+                const auto kernel = builtins::numericKernel(builtin->getFunc());
+                if (kernel != nullptr && kernel->kind != builtins::NumericKernel::Kind::COMPARE &&
+                    canFold(*kernel, pair->getCdr())) {
+                    return foldNumeric(builtin, *kernel, pair->getCdr());
+                }
+            }
+            // any other call, except a macro use, is applied without resolving the head again
+            if (proc->getType() == ValueType::BUILTIN || proc->getType() == ValueType::LAMBDA) {
+                boxed = apply(proc, evalList(pair->getCdr()));
+                return unboxed(boxed);
+            }
+        }
+    }
+    boxed = this->eval(expr);
+    return unboxed(boxed);
+}
+
+static std::optional<builtins::PipelineStage::Kind> pipelineKind(const Value* proc) {
+    if (proc->getType() != ValueType::BUILTIN) {
+        return std::nullopt;
+    }
+    const auto func = static_cast<const BuiltinProcValue*>(proc)->getFunc();
+    if (func == &builtins::map) {
+        return builtins::PipelineStage::Kind::MAP;
+    }
+    if (func == &builtins::filter) {
+        return builtins::PipelineStage::Kind::FILTER;
+    }
+    return std::nullopt;
+}
+
+std::optional<ValuePtr> EvalEnv::evalPipelineCall(const BuiltinProcValue* proc,
+                                                  const ValuePtr& argList) {
+    const bool isReduce = proc->getFunc() == &builtins::reduce;
+    const auto outerKind = pipelineKind(proc);
+    if (!isReduce && !outerKind) {
+        return std::nullopt;
+    }
+    auto args = twoArguments(argList);
+    if (!args) {
+        return std::nullopt;
+    }
+
+    // collect the chain of nested map/filter calls, outermost first
+    std::vector<std::pair<std::optional<builtins::PipelineStage::Kind>, ValuePtr>> chain = {
+        {outerKind, args->first}};
+    auto source = args->second;
+    while (source->getType() == ValueType::PAIR) {
+        const auto inner = static_cast<PairValue*>(source);
+        if (inner->getCar()->getType() != ValueType::SYMBOL || specialFormOf(inner->getCar())) {
+            break;
+        }
+        const auto innerKind = pipelineKind(this->eval(inner->getCar()));
+        const auto innerArgs = twoArguments(inner->getCdr());
+        if (!innerKind || !innerArgs) {
+            break;
+        }
+        chain.emplace_back(innerKind, innerArgs->first);
+        source = innerArgs->second;
+    }
+    if (chain.size() == 1) {  // nothing to fuse
+        return std::nullopt;
+    }
+
+    // evaluate the arguments in the same order as the nested calls would
+    std::vector<builtins::PipelineStage> stages;
+    ValuePtr reducer = nullptr;
+    for (const auto& [kind, funcExpr] : chain) {
+        const auto func = this->eval(funcExpr);
+        if (kind) {
+            stages.push_back({*kind, func});
+        } else {
+            reducer = func;
+        }
+    }
+    const auto list = this->eval(source);
+    std::ranges::reverse(stages);
+    return builtins::runPipeline(stages, list, reducer);
+}
+
+ValuePtr EvalEnv::lookupVariable(ValuePtr symbol) const {
+    const auto& name = static_cast<SymbolValue*>(symbol)->getValue();
+    // A resolved reference is valid if it leads to a frame of the layout it was resolved for,
+    // and no variable defined by name on the way, e.g. by `eval`, hides it
+    if (const auto& address = static_cast<SymbolValue*>(symbol)->getAddress(); address.layout) {
+        auto env = this;
+        size_t up = 0;
+        for (; up < address.depth && env != nullptr && env->symbolTable.empty(); up++) {
+            env = env->parent;
+        }
+        if (up == address.depth && env != nullptr && env->layout == address.layout &&
+            env->slots[address.index] != nullptr) {
+            return env->slots[address.index];
+        }
+    }
+    if (const auto value = lookupBinding(name)) {
+        return value;
+    }
+    throw ValueError(std::format("Undefined variable: {}", name), symbol->getLocation());
 }
 
 ValuePtr EvalEnv::lookupBinding(const std::string& name) const {
-    try {
-        return symbolTable.at(name);
-    } catch (const std::out_of_range&) {
-        if (parent) {
-            return parent->lookupBinding(name);
+    for (auto env = this; env != nullptr; env = env->parent) {
+        // a variable whose definition has not run yet is looked up further out, like an
+        // undefined one
+        for (size_t i = 0; i < env->slots.size(); i++) {
+            if (env->slots[i] != nullptr && (*env->layout)[i] == name) {
+                return env->slots[i];
+            }
+        }
+        if (env->symbolTable.empty()) {
+            continue;
+        }
+        if (const auto it = env->symbolTable.find(name); it != env->symbolTable.end()) {
+            return it->second;
         }
-        throw ValueError(std::format("Undefined variable: {}", name), std::nullopt);
     }
+    return nullptr;
 }
 
-std::vector<std::string> EvalEnv::loadStack = {};
\ No newline at end of file
+std::vector<std::string> EvalEnv::loadStack = {};
+
+size_t EvalEnv::maxDepth = 10000;
+
+size_t EvalEnv::depth = 0;
+
+size_t EvalEnv::redefinitions = 0;
\ No newline at end of file
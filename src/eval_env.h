@@ -1,20 +1,51 @@
 #ifndef EVAL_ENV_H
 #define EVAL_ENV_H
 
+#include <memory>
 #include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "number.h"
+
 class Value;
+class BuiltinProcValue;
+class LambdaValue;
 using ValuePtr = Value*;
 
+namespace builtins {
+struct NumericKernel;
+}
+
 class EvalEnv {
     std::unordered_map<std::string, ValuePtr> symbolTable;
     const EvalEnv* parent;
 
+    // Variables known ahead of time, e.g. the parameters and internal definitions of a procedure,
+    // live in slots instead of `symbolTable`. A slot is nullptr until its variable is defined.
+    std::shared_ptr<const std::vector<std::string>> layout;
+    std::vector<ValuePtr> slots;
+
+    // the procedure this environment is a call frame of, if any
+    const LambdaValue* owner = nullptr;
+    // whether a closure may still refer to this environment after it is left
+    mutable bool captured = false;
+
+    static size_t depth;
+
     void addBuiltins();
-    ValuePtr lookupBinding(const std::string& name) const;
+    ValuePtr evalAtom(ValuePtr expr);
+    /// The value bound to a symbol, throwing a ValueError if it is unbound
+    ValuePtr lookupVariable(ValuePtr symbol) const;
+    ValuePtr* findSlot(const std::string& name);
+
+    std::optional<ValuePtr> evalNumericCall(const BuiltinProcValue* proc, const ValuePtr& argList);
+    Number foldNumeric(const BuiltinProcValue* proc, const builtins::NumericKernel& kernel,
+                       const ValuePtr& argList);
+    std::optional<Number> evalOperand(const ValuePtr& expr, ValuePtr& boxed);
+
+    std::optional<ValuePtr> evalPipelineCall(const BuiltinProcValue* proc, const ValuePtr& argList);
 
     EvalEnv();
     explicit EvalEnv(const EvalEnv* parent);
@@ -34,6 +65,12 @@ public:
 
     static ValuePtr apply(const ValuePtr& proc, const std::vector<ValuePtr>& args);
 
+    /**
+     * Apply a procedure whose result is kept, e.g. as an element of a list, by the caller
+     * @throw ValueError if the procedure returns multiple values
+     */
+    static ValuePtr applyForValue(const ValuePtr& proc, const std::vector<ValuePtr>& args);
+
     std::vector<ValuePtr> evalList(const ValuePtr& expr);
 
     /**
@@ -45,12 +82,58 @@ public:
      */
     std::optional<ValuePtr> addVariable(const std::string& name, const ValuePtr& value);
 
+    /**
+     * Assign to an existing variable in the environment that defines it, this one or a parent
+     * @return false if the variable is not defined
+     */
+    bool assignVariable(const std::string& name, const ValuePtr& value);
+
     bool removeVariable(const std::string& name);
+
+    /**
+     * Reserve slots for variables that will be defined in this environment, so defining them does
+     * not insert into a hash table
+     * @param names the variables, all undefined at first
+     */
+    void reserveSlots(std::shared_ptr<const std::vector<std::string>> names);
+
+    /**
+     * Define the variable of a reserved slot
+     * @param index index of the variable in the names passed to `reserveSlots`
+     */
+    void setSlot(size_t index, ValuePtr value);
+
+    /**
+     * Find the value bound to a name in this environment or its parents
+     * @return the value, or nullptr if the name is unbound
+     */
+    ValuePtr lookupBinding(const std::string& name) const;
+
+    /**
+     * Mark the environment and its parents as captured, e.g. by a closure created in it. A captured
+     * environment is never reused for another call or loop iteration.
+     */
+    void capture() const;
+    bool isCaptured() const;
+
     std::vector<std::string> variables() const;
 
     static std::vector<std::string> loadStack;
 
+    /**
+     * Maximum nesting depth of `eval`, set by LISP_MAX_DEPTH. Evaluating deeper raises a
+     * RecursionError, and so does running out of native stack before reaching the limit.
+     */
+    static size_t maxDepth;
+
+    /**
+     * Number of times a global binding has been replaced, code analysis depending on globals is
+     * stale when it changes
+     */
+    static size_t redefinitions;
+
     friend class ValuePool;
+    friend class LambdaValue;
 };
 
 #endif  // EVAL_ENV_H
@@ -1,5 +1,6 @@
 #include "forms.h"
 
+#include <algorithm>
 #include <filesystem>
 #include <ranges>
 
@@ -11,8 +12,11 @@
 
 #include "error.h"
 #include "eval_env.h"
+#include "macro.h"
+#include "match.h"
 #include "parser.h"
 #include "pool.h"
+#include "record.h"
 #include "tokenizer.h"
 #include "utils.h"
 #include "value.h"
@@ -20,6 +24,7 @@
 // clang-format off
 const std::unordered_map<std::string, SpecialFormType*> SPECIAL_FORMS = {
     {"define", &defineForm},
+    {"set!", &setForm},
     {"quote", &quoteForm},
     {"if", &ifForm},
     {"and", &andForm},
@@ -27,14 +32,23 @@ const std::unordered_map<std::string, SpecialFormType*> SPECIAL_FORMS = {
     {"lambda", &lambdaForm},
     {"eval", &evalForm},
     {"cond", &condForm},
+    {"case", &caseForm},
+    {"match", &matchForm},
     {"begin", &beginForm},
     {"let", &letForm},
+    {"letrec", &letrecForm},
+    {"let-values", &letValuesForm},
+    {"letrec*", &letrecForm},
+    {"do", &doForm},
     {"quasiquote", &quasiquoteForm},
-    {"require", &requireForm}
+    {"require", &requireForm},
+    {"defmacro", &defmacroForm},
+    {"define-syntax", &defineSyntaxForm},
+    {"define-record-type", &defineRecordTypeForm}
 };
 // clang-format on
 
-ValuePtr defineForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
+FormResult defineForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
     if (params.size() < 2) {
         throw ValueError("define: expected at least two arguments", Location::fromRange(params));
     }
@@ -48,7 +62,7 @@ ValuePtr defineForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
         }
         std::vector procParams = {pair->getCdr()};
         procParams.insert(procParams.end(), params.begin() + 1, params.end());
-        const auto lambda = lambdaForm(procParams, env);
+        const auto lambda = lambdaForm(procParams, env).value;
         env->addVariable(*procName, lambda);
     } else {
         throw ValueError("define: expected a symbol or a pair as the first argument",
@@ -57,7 +71,21 @@ ValuePtr defineForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
     return LISP_NIL;
 }
 
-ValuePtr quoteForm(const std::vector<ValuePtr>& params, EvalEnv*) {
+FormResult setForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
+    CHECK_PARAM_NUM(set!, 2);
+    const auto name = params[0]->asSymbolName();
+    if (!name.has_value()) {
+        throw ValueError("set!: expected a symbol as the first argument", params[0]->getLocation());
+    }
+    // Closures share the environments they capture, so assigning the binding in its environment
+    // is seen by all of them and no variable needs to be boxed
+    if (!env->assignVariable(*name, env->eval(params[1]))) {
+        throw ValueError(std::format("Undefined variable: {}", *name), params[0]->getLocation());
+    }
+    return LISP_NIL;
+}
+
+FormResult quoteForm(const std::vector<ValuePtr>& params, EvalEnv*) {
     CHECK_PARAM_NUM(quote, 1);
     return params[0];
 }
@@ -69,71 +97,122 @@ bool convertToBool(const ValuePtr& value) {
     return true;
 }
 
-ValuePtr ifForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
+FormResult ifForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
     CHECK_PARAM_NUM(if, 3);
     if (const auto condition = env->eval(params[0]); convertToBool(condition)) {
-        return env->eval(params[1]);
+        return {params[1], env};
     }
     if (params.size() == 3) {
-        return env->eval(params[2]);
+        return {params[2], env};
     }
     return LISP_NIL;
 }
 
-ValuePtr andForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
-    for (const auto& param : params) {
+FormResult andForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
+    if (params.empty()) {
+        return LISP_BOOL(true);
+    }
+    for (const auto& param : std::views::take(params, params.size() - 1)) {
         if (const auto value = env->eval(param); !convertToBool(value)) {
             return LISP_BOOL(false);
         }
     }
-    const size_t len = params.size();
-    if (len == 0) {
-        return LISP_BOOL(true);
-    }
-    return env->eval(params[len - 1]);
+    return {params.back(), env};
 }
 
-ValuePtr orForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
-    for (const auto& arg : params) {
+FormResult orForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
+    if (params.empty()) {
+        return LISP_BOOL(false);
+    }
+    for (const auto& arg : std::views::take(params, params.size() - 1)) {
         if (const auto value = env->eval(arg); convertToBool(value)) {
             return value;
         }
     }
-    return LISP_BOOL(false);
+    // the last value is the result whether it is true or not
+    return {params.back(), env};
 }
 
-ValuePtr lambdaForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
+/**
+ * Frame layout of a lambda expression, computed once and cached in its parameter list
+ */
+class LambdaLayout : public CodeCache {
+public:
+    std::shared_ptr<const FrameLayout> layout;
+    size_t paramCount = 0;
+    RestParam rest = RestParam::NONE;
+    size_t analyzed = 0;  // value of EvalEnv::redefinitions when `rest` was determined
+};
+
+FormResult lambdaForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
     CHECK_EMPTY_PARAMS(lambda);
     const auto lambdaParams = dynamic_cast<PairValue*>(params[0]);
-    const auto body = std::vector(params.begin() + 1, params.end());
-    if (lambdaParams == nullptr && params[0]->getType() != ValueType::NIL) {
-        throw ValueError("lambda: expected a pair of parameters", params[0]->getLocation());
-    }
-    if (lambdaParams == nullptr) {  // no parameters
-        return ValuePool::instance()->makeValue<LambdaValue>(std::vector<std::string>{}, body, env);
+    auto body = std::vector(params.begin() + 1, params.end());
+    // the closure keeps referring to its environment
+    env->capture();
+    if (lambdaParams != nullptr) {
+        if (const auto cached = dynamic_cast<LambdaLayout*>(lambdaParams->getCache())) {
+            if (cached->rest == RestParam::UNUSED && cached->analyzed != EvalEnv::redefinitions) {
+                cached->rest = LambdaValue::restParam((*cached->layout)[cached->paramCount],
+                                                      *cached->layout, body, env);
+                cached->analyzed = EvalEnv::redefinitions;
+            }
+            return ValuePool::instance()->makeValue<LambdaValue>(
+                cached->layout, cached->paramCount, cached->rest, std::move(body), env);
+        }
     }
-    auto paramsList = std::vector<std::string>{};
-    auto paramsVec = lambdaParams->toVector();
-    removeTrailingNil(paramsVec);
 
-    for (const auto& param : paramsVec) {
+    // `(a b)`, `(a b . rest)` or just `rest`
+    auto paramsList = std::vector<std::string>{};
+    auto restName = params[0]->asSymbolName();
+    if (lambdaParams == nullptr && !restName.has_value() &&
+        params[0]->getType() != ValueType::NIL) {
+        throw ValueError("lambda: expected a pair of parameters", params[0]->getLocation());
+    }
+    auto current = params[0];
+    while (current->getType() == ValueType::PAIR) {
+        const auto param = static_cast<PairValue*>(current)->getCar();
         if (const auto name = param->asSymbolName(); name.has_value()) {
             paramsList.push_back(*name);
         } else {
             throw ValueError("lambda: expected a list of symbols as parameters",
                              param->getLocation());
         }
+        current = static_cast<PairValue*>(current)->getCdr();
+    }
+    if (lambdaParams != nullptr && current->getType() != ValueType::NIL) {
+        restName = current->asSymbolName();
+        if (!restName.has_value()) {
+            throw ValueError("lambda: expected a symbol as the rest parameter",
+                             current->getLocation());
+        }
     }
 
-    return ValuePool::instance()->makeValue<LambdaValue>(paramsList, body, env);
+    const auto layout = std::make_shared<LambdaLayout>();
+    layout->paramCount = paramsList.size();
+    if (restName.has_value()) {
+        paramsList.push_back(*restName);
+    }
+    layout->layout = LambdaValue::frameLayout(std::move(paramsList), body);
+    if (restName.has_value()) {
+        layout->rest = LambdaValue::restParam(*restName, *layout->layout, body, env);
+        layout->analyzed = EvalEnv::redefinitions;
+    }
+    if (lambdaParams != nullptr) {
+        // analyzed once per lambda expression, like the layout
+        LambdaValue::resolveSlots(layout->layout, body, env);
+        lambdaParams->setCache(layout);
+    }
+    return ValuePool::instance()->makeValue<LambdaValue>(layout->layout, layout->paramCount,
+                                                         layout->rest, std::move(body), env);
 }
 
-ValuePtr evalForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
+FormResult evalForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
     CHECK_PARAM_NUM(eval, 1);
-    return env->eval(env->eval(params[0]));
+    return {ValuePool::instance()->evalCache().canonical(env->eval(params[0])), env};
 }
 
-ValuePtr condForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
+FormResult condForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
     CHECK_EMPTY_PARAMS(cond);
     const size_t len = params.size();
     for (auto [i, v] : std::views::enumerate(params)) {
@@ -162,10 +241,10 @@ ValuePtr condForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
                 return result;
             }
 
-            for (const auto& expr : std::vector(pairVec.begin() + 1, pairVec.end())) {
-                result = env->eval(expr);
+            for (const auto& expr : std::vector(pairVec.begin() + 1, pairVec.end() - 1)) {
+                env->eval(expr);
             }
-            return result;
+            return {pairVec.back(), env};
         }
         if (i == len - 1) {
             return result;
@@ -174,40 +253,303 @@ ValuePtr condForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
     throw InternalError("cond: unexpected error", std::nullopt);
 }
 
-ValuePtr beginForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
-    ValuePtr result = LISP_NIL;
-    for (const auto& expr : params) {
-        result = env->eval(expr);
+/**
+ * Dispatch table of a `case`, built once and cached in its first clause. Fixnum data close enough
+ * together are indexed directly, other numbers and symbols through hash tables. Numbers match as
+ * by `eqv?`, so exact and inexact numbers are different keys.
+ */
+class CaseTable : public CodeCache {
+public:
+    static constexpr size_t NO_CLAUSE = -1;
+
+    struct Clause {
+        std::vector<ValuePtr> body;
+        bool arrow = false;  // `(data => proc)`, the body is the procedure
+    };
+
+    struct NumberHash {
+        size_t operator()(const Number& number) const {
+            return number.hash();
+        }
+    };
+    struct SameNumber {
+        bool operator()(const Number& a, const Number& b) const {
+            return a.same(b);
+        }
+    };
+
+    std::vector<Clause> clauses;
+    size_t elseClause = NO_CLAUSE;
+    std::unordered_map<std::string, size_t> symbols;
+    std::unordered_map<Number, size_t, NumberHash, SameNumber> numbers;
+    std::vector<size_t> dense;  // clause of every fixnum from `denseBase` on
+    int64_t denseBase = 0;
+    size_t booleans[2] = {NO_CLAUSE, NO_CLAUSE};
+    size_t nil = NO_CLAUSE;
+
+    size_t find(const ValuePtr& key) const;
+    std::vector<ValuePtr> children() const override;
+};
+
+size_t CaseTable::find(const ValuePtr& key) const {
+    size_t result = NO_CLAUSE;
+    switch (key->getType()) {
+        case ValueType::NUMBER: {
+            const auto& number = static_cast<NumericValue*>(key)->getNumber();
+            if (const auto fixnum = number.asFixnum(); fixnum.has_value() && !dense.empty()) {
+                // fixnums below the base wrap around to indices past the end
+                const auto index =
+                    static_cast<uint64_t>(*fixnum) - static_cast<uint64_t>(denseBase);
+                if (index < dense.size()) {
+                    result = dense[index];
+                }
+            } else if (const auto it = numbers.find(number); it != numbers.end()) {
+                result = it->second;
+            }
+            break;
+        }
+        case ValueType::SYMBOL:
+            if (const auto it = symbols.find(static_cast<SymbolValue*>(key)->getValue());
+                it != symbols.end()) {
+                result = it->second;
+            }
+            break;
+        case ValueType::BOOLEAN:
+            result = booleans[static_cast<BooleanValue*>(key)->getValue()];
+            break;
+        case ValueType::NIL:
+            result = nil;
+            break;
+        default:
+            break;
+    }
+    return result == NO_CLAUSE ? elseClause : result;
+}
+
+std::vector<ValuePtr> CaseTable::children() const {
+    std::vector<ValuePtr> result;
+    for (const auto& clause : clauses) {
+        result.insert(result.end(), clause.body.begin(), clause.body.end());
     }
     return result;
 }
 
-ValuePtr letForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
-    CHECK_EMPTY_PARAMS(let);
-    CHECK_TYPE(params[0], PAIR, let, pair);
+static const CaseTable& caseTable(const std::vector<ValuePtr>& clauses) {
+    const auto first = static_cast<PairValue*>(clauses.front());
+    if (const auto cached = dynamic_cast<CaseTable*>(first->getCache())) {
+        return *cached;
+    }
+    const auto table = std::make_shared<CaseTable>();
+    std::vector<std::pair<int64_t, size_t>> fixnums;
+    for (const auto& [i, clause] : std::views::enumerate(clauses)) {
+        CHECK_TYPE(clause, PAIR, case, pair);
+        auto parts = static_cast<PairValue*>(clause)->toVector();
+        CHECK_LIST(parts, case);
+        if (parts.size() < 2) {
+            throw ValueError("case: expected at least one expression in a clause",
+                             clause->getLocation());
+        }
+        CaseTable::Clause parsed;
+        parsed.arrow = parts[1]->asSymbolName() == "=>";
+        if (parsed.arrow && parts.size() != 3) {
+            throw ValueError("case: expected a single procedure after =>", clause->getLocation());
+        }
+        parsed.body.assign(parts.begin() + (parsed.arrow ? 2 : 1), parts.end());
+        table->clauses.push_back(std::move(parsed));
+        const size_t index = table->clauses.size() - 1;
 
-    // add variables to the environment
-    const auto varPair = dynamic_cast<PairValue*>(params[0]);
-    auto varVec = varPair->toVector();
+        if (parts[0]->asSymbolName() == "else") {
+            if (static_cast<size_t>(i) != clauses.size() - 1) {
+                throw ValueError("case: else must be the last clause", clause->getLocation());
+            }
+            table->elseClause = index;
+            continue;
+        }
+        auto data = std::vector<ValuePtr>{};
+        if (parts[0]->getType() == ValueType::PAIR) {
+            data = static_cast<PairValue*>(parts[0])->toVector();
+        }
+        CHECK_LIST(data, case);
+        // the first clause listing a datum takes it
+        for (const auto& datum : data) {
+            switch (datum->getType()) {
+                case ValueType::NUMBER: {
+                    const auto& number = static_cast<NumericValue*>(datum)->getNumber();
+                    if (const auto fixnum = number.asFixnum();
+                        table->numbers.emplace(number, index).second && fixnum.has_value()) {
+                        fixnums.emplace_back(*fixnum, index);
+                    }
+                    break;
+                }
+                case ValueType::SYMBOL:
+                    table->symbols.emplace(static_cast<SymbolValue*>(datum)->getValue(), index);
+                    break;
+                case ValueType::BOOLEAN: {
+                    auto& slot = table->booleans[static_cast<BooleanValue*>(datum)->getValue()];
+                    slot = std::min(slot, index);
+                    break;
+                }
+                case ValueType::NIL:
+                    table->nil = std::min(table->nil, index);
+                    break;
+                default:
+                    throw ValueError("case: expected numbers, symbols, booleans or () as data",
+                                     datum->getLocation());
+            }
+        }
+    }
+
+    // fixnums are looked up by index when that wastes at most three slots for each of them
+    if (!fixnums.empty() && fixnums.size() == table->numbers.size()) {
+        const auto [min, max] = std::ranges::minmax(fixnums | std::views::keys);
+        const auto span = static_cast<uint64_t>(max) - static_cast<uint64_t>(min);
+        if (span < 4 * fixnums.size()) {
+            table->denseBase = min;
+            table->dense.assign(span + 1, CaseTable::NO_CLAUSE);
+            for (const auto& [number, index] : fixnums) {
+                table->dense[static_cast<uint64_t>(number) - static_cast<uint64_t>(min)] = index;
+            }
+            table->numbers.clear();
+        }
+    }
+    first->setCache(table);
+    return *table;
+}
+
+FormResult caseForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
+    if (params.size() < 2) {
+        throw ValueError("case: expected a key and at least one clause",
+                         Location::fromRange(params));
+    }
+    const auto& table = caseTable({params.begin() + 1, params.end()});
+    const auto key = MultipleValues::single(env->eval(params[0]));
+    const size_t index = table.find(key);
+    if (index == CaseTable::NO_CLAUSE) {
+        return LISP_NIL;
+    }
+    const auto& clause = table.clauses[index];
+    if (clause.arrow) {
+        return EvalEnv::apply(env->eval(clause.body.front()), {key});
+    }
+    for (const auto& expr : std::views::take(clause.body, clause.body.size() - 1)) {
+        env->eval(expr);
+    }
+    return {clause.body.back(), env};
+}
+
+FormResult matchForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
+    if (params.size() < 2) {
+        throw ValueError("match: expected a value and at least one clause",
+                         Location::fromRange(params));
+    }
+    CHECK_TYPE(params[1], PAIR, match, pair);
+    const auto first = static_cast<PairValue*>(params[1]);
+    auto tree = dynamic_cast<MatchTree*>(first->getCache());
+    if (tree == nullptr) {
+        const auto compiled =
+            std::make_shared<MatchTree>(std::vector(params.begin() + 1, params.end()));
+        first->setCache(compiled);
+        tree = compiled.get();
+    }
+    return tree->run(MultipleValues::single(env->eval(params[0])), env);
+}
+
+FormResult beginForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
+    if (params.empty()) {
+        return LISP_NIL;
+    }
+    for (const auto& expr : std::views::take(params, params.size() - 1)) {
+        env->eval(expr);
+    }
+    return {params.back(), env};
+}
+
+/**
+ * Split the binding list of `let` or `do` into its bindings
+ * @param list list of bindings, each one a list of a symbol followed by `minExprs` to `maxExprs`
+ * expressions
+ * @return name and expressions of every binding
+ */
+static std::vector<std::pair<std::string, std::vector<ValuePtr>>> parseBindings(
+    const ValuePtr& list, const std::string& formName, size_t minExprs, size_t maxExprs) {
+    std::vector<std::pair<std::string, std::vector<ValuePtr>>> result;
+    if (list->getType() == ValueType::NIL) {
+        return result;
+    }
+    if (list->getType() != ValueType::PAIR) {
+        throw TypeError(formName + " requires a pair as its argument", list->getLocation());
+    }
+    auto varVec = static_cast<PairValue*>(list)->toVector();
     if (varVec.back()->getType() != ValueType::NIL) {
-        throw ValueError("let expected a list as the first argument", varPair->getLocation());
+        throw ValueError(formName + " expected a list as the first argument", list->getLocation());
     }
     varVec.pop_back();
-    std::unordered_map<std::string, ValuePtr> newVarMap;
     for (const auto& var : varVec) {
-        CHECK_TYPE(var, PAIR, let, pair);
-        const auto pair = dynamic_cast<PairValue*>(var);
+        if (var->getType() != ValueType::PAIR) {
+            throw TypeError(formName + " requires a pair as its argument", var->getLocation());
+        }
+        const auto pair = static_cast<PairValue*>(var);
         auto pairVec = pair->toVector();
-        if (pairVec.size() != 3 || pairVec[2]->getType() != ValueType::NIL) {
-            throw ValueError("let: expected a list as the argument", pair->getLocation());
+        if (pairVec.back()->getType() != ValueType::NIL || pairVec.size() < minExprs + 2 ||
+            pairVec.size() > maxExprs + 2) {
+            throw ValueError(formName + ": expected a list as the argument", pair->getLocation());
         }
+        pairVec.pop_back();
         auto name = pairVec[0]->asSymbolName();
         if (!name.has_value()) {
-            throw ValueError("let: expected a symbol as the first element of the list",
+            throw ValueError(formName + ": expected a symbol as the first element of the list",
                              pairVec[0]->getLocation());
         }
-        auto value = env->eval(pairVec[1]);
-        newVarMap[*name] = value;
+        result.emplace_back(*name, std::vector(pairVec.begin() + 1, pairVec.end()));
+    }
+    return result;
+}
+
+/**
+ * `(let name ((var init)...) body...)`, a loop calling `name` to start the next iteration
+ */
+static FormResult namedLetForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
+    const auto name = *params[0]->asSymbolName();
+    if (params.size() < 2) {
+        throw ValueError("let: expected bindings after the loop name", params[0]->getLocation());
+    }
+    std::vector<std::string> names;
+    std::vector<ValuePtr> args;
+    for (const auto& [var, exprs] : parseBindings(params[1], "let", 1, 1)) {
+        names.push_back(var);
+        args.push_back(MultipleValues::single(env->eval(exprs[0])));
+    }
+
+    // The loop is an ordinary procedure bound to `name` in its own environment. Iterations are
+    // self tail calls, which reuse the frame of the previous iteration unless it was captured.
+    // Unlike a closure, the loop does not capture the enclosing frames unless it escapes, so the
+    // enclosing procedure can still reuse its frame for self tail calls.
+    const auto loopEnv = ValuePool::instance()->makeEnv(env);
+    const auto loop = ValuePool::instance()->makeValue<LambdaValue>(
+        names, std::vector(params.begin() + 2, params.end()), loopEnv, params[0]->getLocation());
+    loopEnv->addVariable(name, loop);
+
+    const auto bodyEnv = loop->bind(args);
+    const auto& body = loop->getBody();
+    if (body.empty()) {
+        return LISP_NIL;
+    }
+    for (const auto& expr : std::views::take(body, body.size() - 1)) {
+        bodyEnv->eval(expr);
+    }
+    return {body.back(), bodyEnv};
+}
+
+FormResult letForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
+    CHECK_EMPTY_PARAMS(let);
+    if (params[0]->getType() == ValueType::SYMBOL) {
+        return namedLetForm(params, env);
+    }
+
+    // add variables to the environment
+    std::unordered_map<std::string, ValuePtr> newVarMap;
+    for (const auto& [name, exprs] : parseBindings(params[0], "let", 1, 1)) {
+        newVarMap[name] = MultipleValues::single(env->eval(exprs[0]));
     }
     // create a new environment
     auto newEnv = ValuePool::instance()->makeEnv(env);
@@ -215,16 +557,190 @@ ValuePtr letForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
         newEnv->addVariable(name, value);
     }
 
-    // evaluate the body
-    ValuePtr result = LISP_NIL;
-    for (const auto& expr : std::vector(params.begin() + 1, params.end())) {
-        result = newEnv->eval(expr);
+    // evaluate the body, the last expression is in tail position
+    if (params.size() == 1) {
+        return LISP_NIL;
+    }
+    for (const auto& expr : std::vector(params.begin() + 1, params.end() - 1)) {
+        newEnv->eval(expr);
+    }
+    return {params.back(), newEnv};
+}
+
+/**
+ * Bind formals shaped like a lambda parameter list, e.g. `(a b)`, `(a . rest)` or `rest`
+ */
+static void bindFormals(const ValuePtr& formals, const std::vector<ValuePtr>& values,
+                        EvalEnv* env) {
+    std::vector<std::string> names;
+    auto current = formals;
+    for (; current->getType() == ValueType::PAIR;
+         current = static_cast<PairValue*>(current)->getCdr()) {
+        const auto name = static_cast<PairValue*>(current)->getCar()->asSymbolName();
+        if (!name.has_value()) {
+            throw ValueError("let-values: expected a list of symbols as formals",
+                             current->getLocation());
+        }
+        names.push_back(*name);
+    }
+    const auto restName = current->asSymbolName();
+    if (!restName.has_value() && current->getType() != ValueType::NIL) {
+        throw ValueError("let-values: expected a symbol as the rest formal",
+                         current->getLocation());
+    }
+    if (values.size() < names.size() || (!restName.has_value() && values.size() > names.size())) {
+        throw ValueError(std::format("let-values: expected {} values, but got {}", names.size(),
+                                     values.size()),
+                         formals->getLocation());
+    }
+
+    for (size_t i = 0; i < names.size(); i++) {
+        env->addVariable(names[i], values[i]);
     }
+    if (restName.has_value()) {
+        ListBuilder rest;
+        for (const auto& value : std::views::drop(values, names.size())) {
+            rest.push(value);
+        }
+        env->addVariable(*restName, rest.build());
+    }
+}
 
-    return result;
+FormResult letValuesForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
+    CHECK_EMPTY_PARAMS(let-values);
+    // the values are passed through the return area, no list is built for them
+    const auto newEnv = ValuePool::instance()->makeEnv(env);
+    std::vector<ValuePtr> bindings;
+    if (params[0]->getType() == ValueType::PAIR) {
+        bindings = static_cast<PairValue*>(params[0])->toVector();
+    }
+    if (bindings.empty() ? params[0]->getType() != ValueType::NIL
+                         : bindings.back()->getType() != ValueType::NIL) {
+        throw ValueError("let-values expected a list as the first argument",
+                         params[0]->getLocation());
+    }
+    removeTrailingNil(bindings);
+    for (const auto& binding : bindings) {
+        std::vector<ValuePtr> parts;
+        if (binding->getType() == ValueType::PAIR) {
+            parts = static_cast<PairValue*>(binding)->toVector();
+        }
+        if (parts.size() != 3 || parts[2]->getType() != ValueType::NIL) {
+            throw ValueError("let-values: expected bindings of the form (formals expression)",
+                             binding->getLocation());
+        }
+        bindFormals(parts[0], MultipleValues::unpack(env->eval(parts[1])), newEnv);
+    }
+
+    if (params.size() == 1) {
+        return LISP_NIL;
+    }
+    for (const auto& expr : std::views::take(std::views::drop(params, 1), params.size() - 2)) {
+        newEnv->eval(expr);
+    }
+    return {params.back(), newEnv};
+}
+
+/**
+ * Variables and initializers of a `letrec`, parsed once and cached in its binding list
+ */
+class LetrecBindings : public CodeCache {
+public:
+    std::shared_ptr<const FrameLayout> names = std::make_shared<const FrameLayout>();
+    std::vector<ValuePtr> inits;
+};
+
+static const LetrecBindings& letrecBindings(const ValuePtr& list) {
+    static const LetrecBindings empty;
+    if (list->getType() != ValueType::PAIR) {
+        parseBindings(list, "letrec", 1, 1);  // reports anything but an empty list
+        return empty;
+    }
+    const auto pair = static_cast<PairValue*>(list);
+    if (const auto cached = dynamic_cast<LetrecBindings*>(pair->getCache())) {
+        return *cached;
+    }
+    const auto bindings = std::make_shared<LetrecBindings>();
+    FrameLayout names;
+    for (auto& [name, exprs] : parseBindings(list, "letrec", 1, 1)) {
+        names.push_back(std::move(name));
+        bindings->inits.push_back(exprs[0]);
+    }
+    bindings->names = std::make_shared<const FrameLayout>(std::move(names));
+    pair->setCache(bindings);
+    return *bindings;
+}
+
+FormResult letrecForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
+    CHECK_EMPTY_PARAMS(letrec);
+    // the variables are in scope of all initializers, which are evaluated from left to right
+    const auto& bindings = letrecBindings(params[0]);
+    const auto newEnv = ValuePool::instance()->makeEnv(env);
+    newEnv->reserveSlots(bindings.names);
+    for (size_t i = 0; i < bindings.inits.size(); i++) {
+        newEnv->setSlot(i, newEnv->eval(bindings.inits[i]));
+    }
+
+    if (params.size() == 1) {
+        return LISP_NIL;
+    }
+    for (const auto& expr : std::views::take(std::views::drop(params, 1), params.size() - 2)) {
+        newEnv->eval(expr);
+    }
+    return {params.back(), newEnv};
+}
+
+FormResult doForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
+    if (params.size() < 2) {
+        throw ValueError("do: expected bindings and a termination clause",
+                         Location::fromRange(params));
+    }
+    const auto bindings = parseBindings(params[0], "do", 1, 2);
+    CHECK_TYPE(params[1], PAIR, do, pair);
+    auto exit = static_cast<PairValue*>(params[1])->toVector();
+    CHECK_LIST(exit, do);
+    const auto commands = std::views::drop(params, 2);
+
+    auto loopEnv = ValuePool::instance()->makeEnv(env);
+    for (const auto& [name, exprs] : bindings) {
+        loopEnv->addVariable(name, env->eval(exprs[0]));
+    }
+    std::vector<ValuePtr> steps(bindings.size());
+    while (!convertToBool(loopEnv->eval(exit[0]))) {
+        for (const auto& command : commands) {
+            loopEnv->eval(command);
+        }
+        for (size_t i = 0; i < bindings.size(); i++) {
+            const auto& exprs = bindings[i].second;
+            steps[i] =
+                exprs.size() == 2 ? MultipleValues::single(loopEnv->eval(exprs[1])) : nullptr;
+        }
+        // Every iteration has fresh bindings, but they only need a fresh environment when a
+        // closure captured the previous one. Otherwise the variables are updated in place.
+        if (loopEnv->isCaptured()) {
+            const auto previous = loopEnv;
+            loopEnv = ValuePool::instance()->makeEnv(env);
+            for (const auto& [name, exprs] : bindings) {
+                loopEnv->addVariable(name, previous->lookupBinding(name));
+            }
+        }
+        for (size_t i = 0; i < bindings.size(); i++) {
+            if (steps[i] != nullptr) {
+                loopEnv->addVariable(bindings[i].first, steps[i]);
+            }
+        }
+    }
+
+    if (exit.size() == 1) {
+        return LISP_NIL;
+    }
+    for (const auto& expr : std::views::take(std::views::drop(exit, 1), exit.size() - 2)) {
+        loopEnv->eval(expr);
+    }
+    return {exit.back(), loopEnv};
 }
 
-ValuePtr quasiquoteForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
+FormResult quasiquoteForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
     CHECK_PARAM_NUM(quasiquote, 1);
     CHECK_TYPE(params[0], PAIR, quasiquote, pair);
     std::vector<ValuePtr> result;
@@ -242,7 +758,7 @@ ValuePtr quasiquoteForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
             if (pair->getCar()->asSymbolName() == "unquote") {
                 CHECK_TYPE(pair->getCdr(), PAIR, quasiquote, pair);
                 const auto unquoteArg = dynamic_cast<PairValue*>(pair->getCdr())->getCar();
-                result.push_back(env->eval(unquoteArg));
+                result.push_back(MultipleValues::single(env->eval(unquoteArg)));
                 continue;
             }
         }
@@ -295,7 +811,7 @@ std::vector<std::string> readLispPath() {
     return paths;
 }
 
-ValuePtr requireForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
+FormResult requireForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
     CHECK_PARAM_NUM(require, 1);
     CHECK_TYPE(params[0], STRING, require, string);
     const auto moduleName = dynamic_cast<StringValue*>(params[0])->getValue();
@@ -366,4 +882,175 @@ ValuePtr requireForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
         env->eval(parser.parse());
     }
     return LISP_NIL;
-}
\ No newline at end of file
+}
+
+FormResult defmacroForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
+    if (params.size() < 2) {
+        throw ValueError("defmacro: expected at least two arguments", Location::fromRange(params));
+    }
+    // both `(defmacro (name args...) body...)` and `(defmacro name (args...) body...)`
+    auto name = params[0]->asSymbolName();
+    std::vector<ValuePtr> transformerParams;
+    if (name.has_value()) {
+        transformerParams.assign(params.begin() + 1, params.end());
+    } else if (const auto pair = dynamic_cast<PairValue*>(params[0]); pair != nullptr) {
+        name = pair->getCar()->asSymbolName();
+        if (!name.has_value()) {
+            throw ValueError("defmacro: expected a symbol as the macro name",
+                             pair->getCar()->getLocation());
+        }
+        transformerParams = {pair->getCdr()};
+        transformerParams.insert(transformerParams.end(), params.begin() + 1, params.end());
+    } else {
+        throw ValueError("defmacro: expected a symbol or a pair as the first argument",
+                         params[0]->getLocation());
+    }
+    const auto transformer = lambdaForm(transformerParams, env).value;
+    env->addVariable(*name, ValuePool::instance()->makeValue<ProcMacroValue>(
+                                transformer, params[0]->getLocation()));
+    return LISP_NIL;
+}
+
+FormResult defineSyntaxForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
+    CHECK_PARAM_NUM(define-syntax, 2);
+    const auto name = params[0]->asSymbolName();
+    if (!name.has_value()) {
+        throw ValueError("define-syntax: expected a symbol as the first argument",
+                         params[0]->getLocation());
+    }
+    const auto spec = dynamic_cast<PairValue*>(params[1]);
+    if (spec == nullptr || spec->getCar()->asSymbolName() != "syntax-rules") {
+        throw ValueError("define-syntax: expected a syntax-rules form", params[1]->getLocation());
+    }
+    auto parts = spec->toVector();
+    removeTrailingNil(parts);
+    if (parts.size() < 2) {
+        throw ValueError("syntax-rules: expected a list of literals", spec->getLocation());
+    }
+
+    std::vector<std::string> literals;
+    if (parts[1]->getType() == ValueType::PAIR) {
+        auto literalValues = static_cast<PairValue*>(parts[1])->toVector();
+        removeTrailingNil(literalValues);
+        for (const auto& literal : literalValues) {
+            const auto literalName = literal->asSymbolName();
+            if (!literalName.has_value()) {
+                throw ValueError("syntax-rules: expected a list of symbols as literals",
+                                 literal->getLocation());
+            }
+            literals.push_back(*literalName);
+        }
+    } else if (parts[1]->getType() != ValueType::NIL) {
+        throw ValueError("syntax-rules: expected a list of literals", parts[1]->getLocation());
+    }
+
+    std::vector<std::pair<ValuePtr, ValuePtr>> rules;
+    for (const auto& rule : std::views::drop(parts, 2)) {
+        std::vector<ValuePtr> ruleParts;
+        if (rule->getType() == ValueType::PAIR) {
+            ruleParts = static_cast<PairValue*>(rule)->toVector();
+        }
+        if (ruleParts.size() != 3 || ruleParts[2]->getType() != ValueType::NIL ||
+            ruleParts[0]->getType() != ValueType::PAIR) {
+            throw ValueError("syntax-rules: expected rules of the form ((_ pattern...) template)",
+                             rule->getLocation());
+        }
+        rules.emplace_back(ruleParts[0], ruleParts[1]);
+    }
+    env->addVariable(*name, ValuePool::instance()->makeValue<SyntaxRulesValue>(
+                                std::move(literals), std::move(rules), spec->getLocation()));
+    return LISP_NIL;
+}
+
+static std::string recordName(const ValuePtr& value, const std::string& what) {
+    const auto name = value->asSymbolName();
+    if (!name.has_value()) {
+        throw ValueError(std::format("define-record-type: expected a symbol as the {}", what),
+                         value->getLocation());
+    }
+    return *name;
+}
+
+FormResult defineRecordTypeForm(const std::vector<ValuePtr>& params, EvalEnv* env) {
+    if (params.size() < 3) {
+        throw ValueError("define-record-type: expected at least three arguments",
+                         Location::fromRange(params));
+    }
+    const auto typeName = recordName(params[0], "type name");
+
+    // (field accessor [modifier]) for every field, in slot order
+    std::vector<std::string> fields;
+    std::vector<std::vector<ValuePtr>> fieldSpecs;
+    for (const auto& spec : std::views::drop(params, 3)) {
+        std::vector<ValuePtr> parts;
+        if (spec->getType() == ValueType::PAIR) {
+            parts = static_cast<PairValue*>(spec)->toVector();
+        }
+        if (parts.size() < 3 || parts.size() > 4 || parts.back()->getType() != ValueType::NIL) {
+            throw ValueError("define-record-type: expected fields of the form (field accessor "
+                             "[modifier])",
+                             spec->getLocation());
+        }
+        parts.pop_back();
+        const auto field = recordName(parts[0], "field name");
+        if (std::ranges::find(fields, field) != fields.end()) {
+            throw ValueError(std::format("define-record-type: duplicate field {}", field),
+                             parts[0]->getLocation());
+        }
+        fields.push_back(field);
+        fieldSpecs.push_back(std::move(parts));
+    }
+    const auto offsetOf = [&](const ValuePtr& field) {
+        const auto it = std::ranges::find(fields, recordName(field, "field name"));
+        if (it == fields.end()) {
+            throw ValueError(std::format("define-record-type: unknown field {}", field->toString()),
+                             field->getLocation());
+        }
+        return static_cast<size_t>(it - fields.begin());
+    };
+
+    const auto pool = ValuePool::instance();
+    const auto type = pool->makeValue<RecordTypeValue>(typeName, fields, params[0]->getLocation());
+    env->addVariable(typeName, type);
+
+    // `(make-point x y)` takes the listed fields, a bare `make-point` takes all of them
+    std::string constructorName;
+    std::vector<size_t> constructorOffsets;
+    if (params[1]->getType() == ValueType::PAIR) {
+        auto parts = static_cast<PairValue*>(params[1])->toVector();
+        if (parts.back()->getType() != ValueType::NIL) {
+            throw ValueError("define-record-type: expected a list as the constructor",
+                             params[1]->getLocation());
+        }
+        parts.pop_back();
+        constructorName = recordName(parts[0], "constructor name");
+        for (const auto& field : std::views::drop(parts, 1)) {
+            constructorOffsets.push_back(offsetOf(field));
+        }
+    } else {
+        constructorName = recordName(params[1], "constructor name");
+        for (size_t i = 0; i < fields.size(); i++) {
+            constructorOffsets.push_back(i);
+        }
+    }
+    using Kind = RecordProcValue::Kind;
+    env->addVariable(constructorName,
+                     pool->makeValue<RecordProcValue>(Kind::CONSTRUCTOR, type, constructorName,
+                                                      std::move(constructorOffsets)));
+    const auto predicateName = recordName(params[2], "predicate name");
+    env->addVariable(predicateName,
+                     pool->makeValue<RecordProcValue>(Kind::PREDICATE, type, predicateName,
+                                                      std::vector<size_t>{}));
+
+    for (size_t i = 0; i < fieldSpecs.size(); i++) {
+        const auto accessorName = recordName(fieldSpecs[i][1], "accessor name");
+        env->addVariable(accessorName, pool->makeValue<RecordProcValue>(
+                                           Kind::ACCESSOR, type, accessorName, std::vector{i}));
+        if (fieldSpecs[i].size() == 3) {
+            const auto modifierName = recordName(fieldSpecs[i][2], "modifier name");
+            env->addVariable(modifierName, pool->makeValue<RecordProcValue>(
+                                               Kind::MODIFIER, type, modifierName, std::vector{i}));
+        }
+    }
+    return LISP_NIL;
+}
@@ -6,32 +6,62 @@
 #include "eval_env.h"
 #include "value.h"
 
-using SpecialFormType = ValuePtr(const std::vector<ValuePtr>&, EvalEnv*);
+/**
+ * Result of a special form. Instead of evaluating the expression in its tail position itself, a
+ * form can hand it back to `EvalEnv::eval` together with the environment to evaluate it in. The
+ * evaluator then continues in a loop, so tail calls do not grow the C++ stack.
+ */
+struct FormResult {
+    ValuePtr value;
+    EvalEnv* tailEnv = nullptr;
+
+    // NOLINTNEXTLINE(google-explicit-constructor): forms return plain values most of the time
+    FormResult(ValuePtr value) : value{value} {}
+    FormResult(ValuePtr expr, EvalEnv* env) : value{expr}, tailEnv{env} {}
+};
 
 extern const std::unordered_map<std::string, SpecialFormType*> SPECIAL_FORMS;
 
-ValuePtr defineForm(const std::vector<ValuePtr>& params, EvalEnv* env);
+FormResult defineForm(const std::vector<ValuePtr>& params, EvalEnv* env);
 
-ValuePtr quoteForm(const std::vector<ValuePtr>& params, EvalEnv* env);
+FormResult setForm(const std::vector<ValuePtr>& params, EvalEnv* env);
 
-ValuePtr ifForm(const std::vector<ValuePtr>& params, EvalEnv* env);
+FormResult quoteForm(const std::vector<ValuePtr>& params, EvalEnv* env);
 
-ValuePtr andForm(const std::vector<ValuePtr>& params, EvalEnv* env);
+FormResult ifForm(const std::vector<ValuePtr>& params, EvalEnv* env);
 
-ValuePtr orForm(const std::vector<ValuePtr>& params, EvalEnv* env);
+FormResult andForm(const std::vector<ValuePtr>& params, EvalEnv* env);
 
-ValuePtr lambdaForm(const std::vector<ValuePtr>& params, EvalEnv* env);
+FormResult orForm(const std::vector<ValuePtr>& params, EvalEnv* env);
 
-ValuePtr evalForm(const std::vector<ValuePtr>& params, EvalEnv* env);
+FormResult lambdaForm(const std::vector<ValuePtr>& params, EvalEnv* env);
 
-ValuePtr condForm(const std::vector<ValuePtr>& params, EvalEnv* env);
+FormResult evalForm(const std::vector<ValuePtr>& params, EvalEnv* env);
 
-ValuePtr beginForm(const std::vector<ValuePtr>& params, EvalEnv* env);
+FormResult condForm(const std::vector<ValuePtr>& params, EvalEnv* env);
 
-ValuePtr letForm(const std::vector<ValuePtr>& params, EvalEnv* env);
+FormResult caseForm(const std::vector<ValuePtr>& params, EvalEnv* env);
 
-ValuePtr quasiquoteForm(const std::vector<ValuePtr>& params, EvalEnv* env);
+FormResult matchForm(const std::vector<ValuePtr>& params, EvalEnv* env);
 
-ValuePtr requireForm(const std::vector<ValuePtr>& params, EvalEnv* env);
+FormResult beginForm(const std::vector<ValuePtr>& params, EvalEnv* env);
+
+FormResult letForm(const std::vector<ValuePtr>& params, EvalEnv* env);
+
+FormResult letValuesForm(const std::vector<ValuePtr>& params, EvalEnv* env);
+
+FormResult letrecForm(const std::vector<ValuePtr>& params, EvalEnv* env);
+
+FormResult doForm(const std::vector<ValuePtr>& params, EvalEnv* env);
+
+FormResult quasiquoteForm(const std::vector<ValuePtr>& params, EvalEnv* env);
+
+FormResult requireForm(const std::vector<ValuePtr>& params, EvalEnv* env);
+
+FormResult defmacroForm(const std::vector<ValuePtr>& params, EvalEnv* env);
+
+FormResult defineSyntaxForm(const std::vector<ValuePtr>& params, EvalEnv* env);
+
+FormResult defineRecordTypeForm(const std::vector<ValuePtr>& params, EvalEnv* env);
 
 #endif  // FORMS_H
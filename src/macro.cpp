@@ -0,0 +1,239 @@
+#include "macro.h"
+
+#include <algorithm>
+#include <format>
+#include <memory>
+
+#include "error.h"
+#include "eval_env.h"
+#include "pool.h"
+#include "utils.h"
+
+std::string MacroValue::toString() const {
+    return "#<macro>";
+}
+
+bool MacroValue::equals(const ValuePtr& other) const {
+    return this == other;
+}
+
+ValuePtr MacroValue::expandCached(PairValue* form) {
+    if (const auto cached = dynamic_cast<MacroExpansion*>(form->getCache());
+        cached != nullptr && cached->macro == this) {
+        return cached->expansion;
+    }
+    const auto expansion = expand(form);
+    form->setCache(std::make_shared<MacroExpansion>(this, expansion));
+    return expansion;
+}
+
+std::vector<ValuePtr> MacroExpansion::children() const {
+    return {macro, expansion};
+}
+
+ValuePtr ProcMacroValue::expand(const PairValue* form) const {
+    std::vector<ValuePtr> operands;
+    if (form->getCdr()->getType() == ValueType::PAIR) {
+        operands = static_cast<PairValue*>(form->getCdr())->toVector();
+        removeTrailingNil(operands);
+    }
+    return EvalEnv::applyForValue(transformer, operands);
+}
+
+std::vector<ValuePtr> ProcMacroValue::children() const {
+    return {transformer};
+}
+
+static bool isEllipsis(const ValuePtr& value) {
+    return value->asSymbolName() == "...";
+}
+
+ValuePtr SyntaxRulesValue::expand(const PairValue* form) const {
+    for (const auto& [pattern, templ] : rules) {
+        // the keyword position of the pattern is ignored
+        SyntaxBindings bindings;
+        if (match(static_cast<PairValue*>(pattern)->getCdr(), form->getCdr(), bindings)) {
+            return instantiate(templ, bindings);
+        }
+    }
+    throw ValueError(std::format("No syntax rule matches {}", form->toString()),
+                     form->getLocation());
+}
+
+std::vector<ValuePtr> SyntaxRulesValue::children() const {
+    std::vector<ValuePtr> result;
+    for (const auto& [pattern, templ] : rules) {
+        result.push_back(pattern);
+        result.push_back(templ);
+    }
+    return result;
+}
+
+bool SyntaxRulesValue::match(ValuePtr pattern, ValuePtr form, SyntaxBindings& bindings) const {
+    if (pattern->getType() == ValueType::PAIR) {
+        return matchList(pattern, form, bindings);
+    }
+    if (pattern->getType() != ValueType::SYMBOL) {
+        return pattern->equals(form);
+    }
+    const auto& name = static_cast<SymbolValue*>(pattern)->getValue();
+    if (name == "_") {
+        return true;
+    }
+    if (std::ranges::find(literals, name) != literals.end()) {
+        return form->asSymbolName() == name;
+    }
+    bindings[name] = SyntaxMatch{form, {}};
+    return true;
+}
+
+bool SyntaxRulesValue::matchList(ValuePtr pattern, ValuePtr form, SyntaxBindings& bindings) const {
+    std::vector<ValuePtr> items;
+    std::optional<size_t> repeated;
+    auto tail = pattern;
+    for (; tail->getType() == ValueType::PAIR; tail = static_cast<PairValue*>(tail)->getCdr()) {
+        const auto item = static_cast<PairValue*>(tail)->getCar();
+        if (isEllipsis(item) && !items.empty() && !repeated) {
+            repeated = items.size() - 1;
+        } else {
+            items.push_back(item);
+        }
+    }
+
+    if (!repeated) {
+        for (const auto& item : items) {
+            if (form->getType() != ValueType::PAIR) {
+                return false;
+            }
+            const auto pair = static_cast<PairValue*>(form);
+            if (!match(item, pair->getCar(), bindings)) {
+                return false;
+            }
+            form = pair->getCdr();
+        }
+        return match(tail, form, bindings);
+    }
+
+    // the repeated item takes as many elements as the items after it leave
+    std::vector<ValuePtr> elements;
+    for (; form->getType() == ValueType::PAIR; form = static_cast<PairValue*>(form)->getCdr()) {
+        elements.push_back(static_cast<PairValue*>(form)->getCar());
+    }
+    if (elements.size() < items.size() - 1) {
+        return false;
+    }
+    const size_t count = elements.size() - (items.size() - 1);
+    auto element = elements.begin();
+    for (size_t i = 0; i < *repeated; i++) {
+        if (!match(items[i], *element++, bindings)) {
+            return false;
+        }
+    }
+
+    std::vector<std::string> names;
+    patternVariables(items[*repeated], names);
+    for (const auto& name : names) {
+        bindings[name] = SyntaxMatch{};
+    }
+    for (size_t i = 0; i < count; i++) {
+        SyntaxBindings repeat;
+        if (!match(items[*repeated], *element++, repeat)) {
+            return false;
+        }
+        for (const auto& name : names) {
+            bindings[name].repeats.push_back(std::move(repeat[name]));
+        }
+    }
+
+    for (size_t i = *repeated + 1; i < items.size(); i++) {
+        if (!match(items[i], *element++, bindings)) {
+            return false;
+        }
+    }
+    return match(tail, form, bindings);
+}
+
+void SyntaxRulesValue::patternVariables(ValuePtr pattern, std::vector<std::string>& names) const {
+    while (pattern->getType() == ValueType::PAIR) {
+        const auto pair = static_cast<PairValue*>(pattern);
+        patternVariables(pair->getCar(), names);
+        pattern = pair->getCdr();
+    }
+    if (const auto name = pattern->asSymbolName()) {
+        const bool literal = std::ranges::find(literals, *name) != literals.end();
+        if (*name != "_" && *name != "..." && !literal) {
+            names.push_back(*name);
+        }
+    }
+}
+
+ValuePtr SyntaxRulesValue::instantiate(ValuePtr templ, const SyntaxBindings& bindings) const {
+    if (templ->getType() == ValueType::SYMBOL) {
+        const auto& name = static_cast<SymbolValue*>(templ)->getValue();
+        const auto binding = bindings.find(name);
+        if (binding == bindings.end()) {
+            return templ;
+        }
+        if (binding->second.value == nullptr) {
+            throw ValueError(
+                std::format("Pattern variable {} must be followed by an ellipsis", name),
+                templ->getLocation());
+        }
+        return binding->second.value;
+    }
+    if (templ->getType() != ValueType::PAIR) {
+        return templ;
+    }
+
+    ListBuilder builder;
+    auto current = templ;
+    while (current->getType() == ValueType::PAIR) {
+        const auto pair = static_cast<PairValue*>(current);
+        const auto next = pair->getCdr();
+        if (next->getType() == ValueType::PAIR &&
+            isEllipsis(static_cast<PairValue*>(next)->getCar())) {
+            for (const auto& value : instantiateRepeat(pair->getCar(), bindings)) {
+                builder.push(value);
+            }
+            current = static_cast<PairValue*>(next)->getCdr();
+        } else {
+            builder.push(instantiate(pair->getCar(), bindings));
+            current = next;
+        }
+    }
+    if (current->getType() == ValueType::NIL) {
+        return builder.build();
+    }
+    return builder.build(instantiate(current, bindings));
+}
+
+std::vector<ValuePtr> SyntaxRulesValue::instantiateRepeat(ValuePtr templ,
+                                                          const SyntaxBindings& bindings) const {
+    std::vector<std::string> names;
+    patternVariables(templ, names);
+    std::erase_if(names, [&](const std::string& name) {
+        const auto binding = bindings.find(name);
+        return binding == bindings.end() || binding->second.value != nullptr;
+    });
+    if (names.empty()) {
+        throw ValueError("Ellipsis does not follow a repeated pattern variable",
+                         templ->getLocation());
+    }
+
+    const size_t count = bindings.at(names.front()).repeats.size();
+    std::vector<ValuePtr> result;
+    for (size_t i = 0; i < count; i++) {
+        auto repeat = bindings;
+        for (const auto& name : names) {
+            const auto& repeats = bindings.at(name).repeats;
+            if (repeats.size() != count) {
+                throw ValueError("Pattern variables under one ellipsis repeat a different number "
+                                 "of times",
+                                 templ->getLocation());
+            }
+            repeat[name] = repeats[i];
+        }
+        result.push_back(instantiate(templ, repeat));
+    }
+    return result;
+}
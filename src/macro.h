@@ -0,0 +1,99 @@
+#ifndef MACRO_H
+#define MACRO_H
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "value.h"
+
+class MacroValue : public Value {
+public:
+    explicit MacroValue(const std::optional<Location>& location = std::nullopt)
+        : Value(ValueType::MACRO, location) {}
+
+    std::string toString() const override;
+    bool equals(const ValuePtr& other) const override;
+
+    /**
+     * Expand a use of the macro
+     * @param form the whole use, including the macro keyword
+     * @return the code the use stands for
+     */
+    virtual ValuePtr expand(const PairValue* form) const = 0;
+
+    /**
+     * Expand a use of the macro, reusing the expansion cached in `form` if it was made by this
+     * macro. Expansions are pure code, so a use inside a lambda body is expanded only once, not
+     * every time the lambda is called.
+     */
+    ValuePtr expandCached(PairValue* form);
+};
+
+/**
+ * A macro defined by `defmacro`, its expansion is computed by a procedure taking the unevaluated
+ * operands.
+ */
+class ProcMacroValue : public MacroValue {
+    ValuePtr transformer;
+
+public:
+    explicit ProcMacroValue(ValuePtr transformer,
+                            const std::optional<Location>& location = std::nullopt)
+        : MacroValue(location), transformer{transformer} {}
+
+    ValuePtr expand(const PairValue* form) const override;
+    std::vector<ValuePtr> children() const override;
+};
+
+/**
+ * Binding of a pattern variable. Variables followed by an ellipsis are bound to a sequence of
+ * matches, one for each repetition.
+ */
+struct SyntaxMatch {
+    ValuePtr value = nullptr;
+    std::vector<SyntaxMatch> repeats;
+};
+
+using SyntaxBindings = std::unordered_map<std::string, SyntaxMatch>;
+
+/**
+ * A macro defined by `define-syntax` and `syntax-rules`. It is not hygienic: symbols introduced
+ * by a template are inserted as is, use `gensym` in `defmacro` when that matters.
+ */
+class SyntaxRulesValue : public MacroValue {
+    std::vector<std::string> literals;
+    std::vector<std::pair<ValuePtr, ValuePtr>> rules;
+
+    bool match(ValuePtr pattern, ValuePtr form, SyntaxBindings& bindings) const;
+    bool matchList(ValuePtr pattern, ValuePtr form, SyntaxBindings& bindings) const;
+    void patternVariables(ValuePtr pattern, std::vector<std::string>& names) const;
+    ValuePtr instantiate(ValuePtr templ, const SyntaxBindings& bindings) const;
+    std::vector<ValuePtr> instantiateRepeat(ValuePtr templ, const SyntaxBindings& bindings) const;
+
+public:
+    SyntaxRulesValue(std::vector<std::string> literals,
+                     std::vector<std::pair<ValuePtr, ValuePtr>> rules,
+                     const std::optional<Location>& location = std::nullopt)
+        : MacroValue(location), literals(std::move(literals)), rules(std::move(rules)) {}
+
+    ValuePtr expand(const PairValue* form) const override;
+    std::vector<ValuePtr> children() const override;
+};
+
+/**
+ * Expansion of a macro use, cached in the list of the use
+ */
+class MacroExpansion : public CodeCache {
+public:
+    MacroValue* macro;
+    ValuePtr expansion;
+
+    MacroExpansion(MacroValue* macro, ValuePtr expansion) : macro{macro}, expansion{expansion} {}
+
+    // the macro is kept alive too, so its address cannot be reused by a new macro
+    std::vector<ValuePtr> children() const override;
+};
+
+#endif  // MACRO_H
@@ -1,9 +1,16 @@
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <format>
 #include <fstream>
 #include <iostream>
 #include <optional>
 #include <string>
 
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
 #include "error.h"
 #include "eval_env.h"
 #include "highlighter.h"
@@ -13,7 +20,7 @@
 #include "tokenizer.h"
 #include "value.h"
 
-int main(int argc, char* argv[]) {
+int runInterpreter(int argc, char* argv[]) {
     const auto env = ValuePool::instance()->root();
     if (argc > 2) {
         std::cerr << "Usage: " << argv[0] << " [script]" << std::endl;
@@ -91,3 +98,68 @@ int main(int argc, char* argv[]) {
     ValuePool::dispose();
     return 0;
 }
+
+/// Largest accepted LISP_MAX_DEPTH, which keeps the reserved stack below half a gigabyte
+constexpr size_t MAX_DEPTH_LIMIT = 100000;
+
+#ifndef _WIN32
+/**
+ * Native stack reserved for every level of `eval` nesting, see EvalEnv::maxDepth. This only sizes
+ * the stack, the evaluator checks how much of it is actually left.
+ */
+constexpr size_t STACK_PER_DEPTH = 4096;
+
+struct InterpreterArgs {
+    int argc;
+    char** argv;
+    int result;
+};
+
+void* interpreterThread(void* arg) {
+    const auto args = static_cast<InterpreterArgs*>(arg);
+    args->result = runInterpreter(args->argc, args->argv);
+    return nullptr;
+}
+#endif
+
+int main(int argc, char* argv[]) {
+    if (const char* depth = std::getenv("LISP_MAX_DEPTH")) {
+        size_t parsed = 0;
+        const auto end = depth + std::strlen(depth);
+        const auto [rest, error] = std::from_chars(depth, end, parsed);
+        if (error != std::errc{} || rest != end || parsed == 0 || parsed > MAX_DEPTH_LIMIT) {
+            std::cerr << std::format("Error: LISP_MAX_DEPTH must be a number from 1 to {}, not {}",
+                                     MAX_DEPTH_LIMIT, depth)
+                      << std::endl;
+            return 1;
+        }
+        EvalEnv::maxDepth = parsed;
+        Parser::maxDepth = parsed;
+    }
+
+#ifdef _WIN32
+    return runInterpreter(argc, argv);
+#else
+    // The evaluator recurses on the native stack. Run it on a thread whose stack is allocated
+    // large enough for EvalEnv::maxDepth levels, so that deep recursion usually reaches the limit
+    // before running out of stack. Either way it ends with a RecursionError.
+    const auto depth = std::max(EvalEnv::maxDepth, Parser::maxDepth);
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    InterpreterArgs args{argc, argv, 0};
+    pthread_t thread;
+    int error = pthread_attr_setstacksize(&attr, (depth + 64) * STACK_PER_DEPTH);
+    if (error == 0) {
+        error = pthread_create(&thread, &attr, &interpreterThread, &args);
+    }
+    pthread_attr_destroy(&attr);
+    if (error != 0) {
+        std::cerr << std::format("Error: cannot reserve the stack for LISP_MAX_DEPTH {}: {}", depth,
+                                 std::strerror(error))
+                  << std::endl;
+        return 1;
+    }
+    pthread_join(thread, nullptr);
+    return args.result;
+#endif
+}
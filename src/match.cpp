@@ -0,0 +1,288 @@
+#include "match.h"
+
+#include <algorithm>
+#include <format>
+#include <ranges>
+#include <set>
+
+#include "error.h"
+#include "eval_env.h"
+#include "pool.h"
+#include "utils.h"
+
+MatchTree::MatchTree(const std::vector<ValuePtr>& clauseValues) {
+    for (const auto& clauseValue : clauseValues) {
+        CHECK_TYPE(clauseValue, PAIR, match, pair);
+        auto parts = static_cast<PairValue*>(clauseValue)->toVector();
+        CHECK_LIST(parts, match);
+        if (parts.size() < 2) {
+            throw ValueError("match: expected at least one expression in a clause",
+                             clauseValue->getLocation());
+        }
+        Clause clause;
+        std::vector<std::string> names;
+        compilePattern(parts[0], 0, clause, names);
+        clause.variables = std::make_shared<const FrameLayout>(std::move(names));
+        clause.body.assign(parts.begin() + 1, parts.end());
+        clauses.push_back(std::move(clause));
+    }
+
+    std::vector<size_t> candidates;
+    for (size_t i = 0; i < clauses.size(); i++) {
+        candidates.push_back(i);
+    }
+    std::map<MemoKey, int> memo;
+    root = build(std::move(candidates), {}, memo);
+}
+
+size_t MatchTree::path(const size_t parent, const bool car) {
+    for (size_t i = 1; i < paths.size(); i++) {
+        if (paths[i].parent == parent && paths[i].car == car) {
+            return i;
+        }
+    }
+    paths.push_back({parent, car});
+    return paths.size() - 1;
+}
+
+size_t MatchTree::test(const TestKind kind, const size_t path, ValuePtr operand) {
+    for (size_t i = 0; i < tests.size(); i++) {
+        const auto& other = tests[i];
+        if (other.kind != kind || other.path != path) {
+            continue;
+        }
+        if (kind == TestKind::PAIR || kind == TestKind::NIL || other.operand == operand) {
+            return i;
+        }
+        // predicates are only known to be the same if they are the same code or variable
+        if ((kind == TestKind::EQUAL || operand->getType() == ValueType::SYMBOL) &&
+            other.operand->getType() == operand->getType() && other.operand->equals(operand)) {
+            return i;
+        }
+    }
+    tests.push_back({kind, path, operand});
+    return tests.size() - 1;
+}
+
+/**
+ * Patterns are
+ * - `_`, matching anything
+ * - a symbol, matching anything and binding it to the variable
+ * - a number, string or boolean, matching values `equal?` to it
+ * - `'datum`, matching values `equal?` to the datum
+ * - `()`, matching the empty list
+ * - `(? pred pattern...)`, matching values for which `pred` returns true and all the patterns match
+ * - `(pattern ...)` or `(pattern ... . pattern)`, matching lists whose elements match
+ */
+void MatchTree::compilePattern(ValuePtr pattern, const size_t path, Clause& clause,
+                               std::vector<std::string>& names) {
+    switch (pattern->getType()) {
+        case ValueType::SYMBOL: {
+            const auto& name = static_cast<SymbolValue*>(pattern)->getValue();
+            if (name == "_") {
+                return;
+            }
+            if (std::ranges::find(names, name) != names.end()) {
+                throw ValueError(std::format("match: variable {} appears twice in a pattern", name),
+                                 pattern->getLocation());
+            }
+            names.push_back(name);
+            clause.bindings.push_back(path);
+            return;
+        }
+        case ValueType::NUMBER:
+        case ValueType::STRING:
+        case ValueType::BOOLEAN:
+            clause.tests.push_back(test(TestKind::EQUAL, path, pattern));
+            return;
+        case ValueType::NIL:
+            clause.tests.push_back(test(TestKind::NIL, path));
+            return;
+        case ValueType::PAIR:
+            break;
+        default:
+            throw ValueError(std::format("match: invalid pattern {}", pattern->toString()),
+                             pattern->getLocation());
+    }
+
+    const auto pair = static_cast<PairValue*>(pattern);
+    const auto head = pair->getCar()->asSymbolName();
+    if (head == "quote" || head == "?") {
+        auto operands = std::vector<ValuePtr>{};
+        if (pair->getCdr()->getType() == ValueType::PAIR) {
+            operands = static_cast<PairValue*>(pair->getCdr())->toVector();
+        }
+        CHECK_LIST(operands, match);
+        if (head == "quote") {
+            if (operands.size() != 1) {
+                throw ValueError("match: quote expects exactly one datum", pattern->getLocation());
+            }
+            clause.tests.push_back(operands[0]->getType() == ValueType::NIL
+                                       ? test(TestKind::NIL, path)
+                                       : test(TestKind::EQUAL, path, operands[0]));
+            return;
+        }
+        if (operands.empty()) {
+            throw ValueError("match: ? expects a predicate", pattern->getLocation());
+        }
+        clause.tests.push_back(test(TestKind::PREDICATE, path, operands[0]));
+        for (const auto& operand : std::views::drop(operands, 1)) {
+            compilePattern(operand, path, clause, names);
+        }
+        return;
+    }
+    clause.tests.push_back(test(TestKind::PAIR, path));
+    compilePattern(pair->getCar(), this->path(path, true), clause, names);
+    compilePattern(pair->getCdr(), this->path(path, false), clause, names);
+}
+
+/**
+ * The answer to a test if it follows from what is known about the same subterm
+ */
+std::optional<bool> MatchTree::answer(const size_t test, const Facts& facts) const {
+    if (const auto fact = facts.find(test); fact != facts.end()) {
+        return fact->second;
+    }
+    const auto& asked = tests[test];
+    if (asked.kind == TestKind::PREDICATE) {
+        return std::nullopt;
+    }
+    for (const auto& [id, result] : facts) {
+        const auto& known = tests[id];
+        if (!result || known.path != asked.path || known.kind == TestKind::PREDICATE) {
+            continue;
+        }
+        // the subterm is known to be a pair, the empty list or a literal
+        if (known.kind == TestKind::EQUAL) {
+            if (asked.kind == TestKind::EQUAL) {
+                return known.operand->equals(asked.operand);
+            }
+            return asked.kind == TestKind::PAIR &&
+                   known.operand->getType() == ValueType::PAIR;
+        }
+        if (asked.kind == TestKind::EQUAL) {
+            if (known.kind == TestKind::NIL || asked.operand->getType() != ValueType::PAIR) {
+                return false;
+            }
+            continue;
+        }
+        return asked.kind == known.kind;
+    }
+    return std::nullopt;
+}
+
+int MatchTree::build(std::vector<size_t> candidates, const Facts& facts,
+                     std::map<MemoKey, int>& memo) {
+    std::erase_if(candidates, [&](size_t candidate) {
+        return std::ranges::any_of(clauses[candidate].tests,
+                                   [&](size_t test) { return answer(test, facts) == false; });
+    });
+    if (candidates.empty()) {
+        return NO_MATCH;
+    }
+
+    // only the facts about subterms the candidates still look at matter
+    std::set<size_t> relevantPaths;
+    for (const auto candidate : candidates) {
+        for (const auto test : clauses[candidate].tests) {
+            relevantPaths.insert(tests[test].path);
+        }
+    }
+    MemoKey key{candidates, {}};
+    for (const auto& fact : facts) {
+        if (relevantPaths.contains(tests[fact.first].path)) {
+            key.second.push_back(fact);
+        }
+    }
+    if (const auto it = memo.find(key); it != memo.end()) {
+        return it->second;
+    }
+
+    const auto& first = clauses[candidates.front()];
+    const auto unknown = std::ranges::find_if(
+        first.tests, [&](size_t test) { return !answer(test, facts).has_value(); });
+    const int index = static_cast<int>(nodes.size());
+    nodes.emplace_back();
+    if (unknown == first.tests.end()) {
+        nodes[index].clause = static_cast<int>(candidates.front());
+    } else {
+        nodes[index].test = *unknown;
+        auto yesFacts = facts;
+        yesFacts[*unknown] = true;
+        const int yes = build(candidates, yesFacts, memo);
+        auto noFacts = facts;
+        noFacts[*unknown] = false;
+        const int no = build(candidates, noFacts, memo);
+        nodes[index].yes = yes;
+        nodes[index].no = no;
+    }
+    memo.emplace(std::move(key), index);
+    return index;
+}
+
+ValuePtr MatchTree::subterm(const size_t path, std::vector<ValuePtr>& values) const {
+    if (values[path] == nullptr) {
+        // the tree only asks about a subterm once its parent is known to be a pair
+        const auto parent = static_cast<PairValue*>(subterm(paths[path].parent, values));
+        values[path] = paths[path].car ? parent->getCar() : parent->getCdr();
+    }
+    return values[path];
+}
+
+bool MatchTree::ask(const Test& test, std::vector<ValuePtr>& values, EvalEnv* env) const {
+    const auto value = subterm(test.path, values);
+    switch (test.kind) {
+        case TestKind::PAIR:
+            return value->getType() == ValueType::PAIR;
+        case TestKind::NIL:
+            return value->getType() == ValueType::NIL;
+        case TestKind::EQUAL:
+            return test.operand->equals(value);
+        case TestKind::PREDICATE: {
+            const auto result = EvalEnv::apply(env->eval(test.operand), {value});
+            return result->getType() != ValueType::BOOLEAN ||
+                   static_cast<BooleanValue*>(result)->getValue();
+        }
+    }
+    throw InternalError("This is a bug, not your fault, please report it", std::nullopt);
+}
+
+FormResult MatchTree::run(ValuePtr value, EvalEnv* env) const {
+    std::vector<ValuePtr> values(paths.size(), nullptr);
+    values[0] = value;
+    int node = root;
+    while (node != NO_MATCH && nodes[node].clause == NO_MATCH) {
+        node = ask(tests[nodes[node].test], values, env) ? nodes[node].yes : nodes[node].no;
+    }
+    if (node == NO_MATCH) {
+        throw ValueError(std::format("match: no pattern matches {}", value->toString()),
+                         value->getLocation());
+    }
+
+    const auto& clause = clauses[nodes[node].clause];
+    auto bodyEnv = env;
+    if (!clause.variables->empty()) {
+        bodyEnv = ValuePool::instance()->makeEnv(env);
+        bodyEnv->reserveSlots(clause.variables);
+        for (size_t i = 0; i < clause.bindings.size(); i++) {
+            bodyEnv->setSlot(i, subterm(clause.bindings[i], values));
+        }
+    }
+    for (const auto& expr : std::views::take(clause.body, clause.body.size() - 1)) {
+        bodyEnv->eval(expr);
+    }
+    return {clause.body.back(), bodyEnv};
+}
+
+std::vector<ValuePtr> MatchTree::children() const {
+    std::vector<ValuePtr> result;
+    for (const auto& test : tests) {
+        if (test.operand != nullptr) {
+            result.push_back(test.operand);
+        }
+    }
+    for (const auto& clause : clauses) {
+        result.insert(result.end(), clause.body.begin(), clause.body.end());
+    }
+    return result;
+}
@@ -0,0 +1,95 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "forms.h"
+#include "value.h"
+
+/**
+ * The clauses of a `match` compiled to a decision tree, cached in the first clause.
+ *
+ * Patterns are split into tests on subterms of the matched value, like "the cdr of the car is a
+ * pair", which clauses share when they test the same thing. The tree asks the tests the first
+ * remaining clause needs, in order, and every answer rules out the clauses that contradict it, so
+ * no subterm is tested twice on the way to the matching clause. Subtrees reached with the same
+ * knowledge are shared, which keeps the tree small when later clauses are independent of the
+ * earlier ones.
+ */
+class MatchTree : public CodeCache {
+    enum class TestKind {
+        PAIR,
+        NIL,
+        EQUAL,      // equal to a literal
+        PREDICATE,  // a procedure returns true for the subterm
+    };
+
+    /// A subterm of the matched value, the car or cdr of its parent. Path 0 is the value itself.
+    struct Path {
+        size_t parent;
+        bool car;
+    };
+
+    struct Test {
+        TestKind kind;
+        size_t path;
+        ValuePtr operand;  // the literal or the predicate expression
+    };
+
+    struct Clause {
+        std::vector<size_t> tests;  // in the order they are asked
+        std::shared_ptr<const FrameLayout> variables;
+        std::vector<size_t> bindings;  // path of every variable
+        std::vector<ValuePtr> body;
+    };
+
+    /// A test with the nodes to go to on either answer, or a leaf selecting a clause
+    struct Node {
+        size_t test = 0;
+        int yes = NO_MATCH;
+        int no = NO_MATCH;
+        int clause = NO_MATCH;
+    };
+
+    using Facts = std::map<size_t, bool>;
+    using MemoKey = std::pair<std::vector<size_t>, std::vector<std::pair<size_t, bool>>>;
+
+    static constexpr int NO_MATCH = -1;
+
+    std::vector<Path> paths{{0, false}};
+    std::vector<Test> tests;
+    std::vector<Clause> clauses;
+    std::vector<Node> nodes;
+    int root = NO_MATCH;
+
+    size_t path(size_t parent, bool car);
+    size_t test(TestKind kind, size_t path, ValuePtr operand = nullptr);
+    void compilePattern(ValuePtr pattern, size_t path, Clause& clause,
+                        std::vector<std::string>& names);
+    std::optional<bool> answer(size_t test, const Facts& facts) const;
+    int build(std::vector<size_t> candidates, const Facts& facts, std::map<MemoKey, int>& memo);
+    ValuePtr subterm(size_t path, std::vector<ValuePtr>& values) const;
+    bool ask(const Test& test, std::vector<ValuePtr>& values, EvalEnv* env) const;
+
+public:
+    /**
+     * Compile the clauses of a `match`
+     * @param clauses the clauses, each one a pattern followed by the body
+     */
+    explicit MatchTree(const std::vector<ValuePtr>& clauses);
+
+    /**
+     * Match a value against the clauses
+     * @return the last expression of the body of the matching clause, to be evaluated in tail
+     * position in a frame binding the pattern variables
+     */
+    FormResult run(ValuePtr value, EvalEnv* env) const;
+
+    std::vector<ValuePtr> children() const override;
+};
+
+#endif  // MATCH_H
@@ -0,0 +1,708 @@
+#include "number.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <format>
+#include <functional>
+#include <limits>
+
+#include "error.h"
+
+using Limbs = BigInt::Limbs;
+
+static constexpr uint64_t LIMB_BASE = uint64_t{1} << 32;
+
+static void trim(Limbs& limbs) {
+    while (!limbs.empty() && limbs.back() == 0) {
+        limbs.pop_back();
+    }
+}
+
+static int compareMagnitude(const Limbs& a, const Limbs& b) {
+    if (a.size() != b.size()) {
+        return a.size() < b.size() ? -1 : 1;
+    }
+    for (size_t i = a.size(); i-- > 0;) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+static Limbs addMagnitude(const Limbs& a, const Limbs& b) {
+    const auto& longer = a.size() >= b.size() ? a : b;
+    const auto& shorter = a.size() >= b.size() ? b : a;
+    Limbs result(longer.size() + 1);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < longer.size(); i++) {
+        const uint64_t sum = carry + longer[i] + (i < shorter.size() ? shorter[i] : 0);
+        result[i] = static_cast<uint32_t>(sum);
+        carry = sum >> 32;
+    }
+    result.back() = static_cast<uint32_t>(carry);
+    trim(result);
+    return result;
+}
+
+/// `a - b`, where `a` is not smaller than `b`
+static Limbs subMagnitude(const Limbs& a, const Limbs& b) {
+    Limbs result(a.size());
+    int64_t borrow = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        int64_t diff = static_cast<int64_t>(a[i]) - borrow - (i < b.size() ? b[i] : 0);
+        borrow = diff < 0;
+        if (diff < 0) {
+            diff += LIMB_BASE;
+        }
+        result[i] = static_cast<uint32_t>(diff);
+    }
+    trim(result);
+    return result;
+}
+
+static Limbs mulSchoolbook(const Limbs& a, const Limbs& b) {
+    if (a.empty() || b.empty()) {
+        return {};
+    }
+    Limbs result(a.size() + b.size());
+    for (size_t i = 0; i < a.size(); i++) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < b.size(); j++) {
+            const uint64_t product = static_cast<uint64_t>(a[i]) * b[j] + result[i + j] + carry;
+            result[i + j] = static_cast<uint32_t>(product);
+            carry = product >> 32;
+        }
+        result[i + b.size()] = static_cast<uint32_t>(carry);
+    }
+    trim(result);
+    return result;
+}
+
+/// Add `value` shifted left by `shift` limbs to `target`, which must be long enough
+static void addShifted(Limbs& target, const Limbs& value, const size_t shift) {
+    uint64_t carry = 0;
+    size_t i = 0;
+    for (; i < value.size() || carry != 0; i++) {
+        const uint64_t sum = carry + target[i + shift] + (i < value.size() ? value[i] : 0);
+        target[i + shift] = static_cast<uint32_t>(sum);
+        carry = sum >> 32;
+    }
+}
+
+static Limbs mulMagnitude(const Limbs& a, const Limbs& b) {
+    if (std::min(a.size(), b.size()) < BigInt::KARATSUBA_THRESHOLD) {
+        return mulSchoolbook(a, b);
+    }
+    // with a = a1 B^half + a0 and b = b1 B^half + b0, a b = z2 B^(2 half) + z1 B^half + z0 where
+    // z0 = a0 b0, z2 = a1 b1 and z1 = (a0 + a1) (b0 + b1) - z0 - z2, three half-size products
+    const size_t half = std::max(a.size(), b.size()) / 2;
+    const auto low = [half](const Limbs& x) {
+        Limbs result(x.begin(), x.begin() + static_cast<ptrdiff_t>(std::min(half, x.size())));
+        trim(result);
+        return result;
+    };
+    const auto high = [half](const Limbs& x) {
+        if (x.size() <= half) {
+            return Limbs{};
+        }
+        return Limbs(x.begin() + static_cast<ptrdiff_t>(half), x.end());
+    };
+    const auto a0 = low(a), a1 = high(a), b0 = low(b), b1 = high(b);
+    const auto z0 = mulMagnitude(a0, b0);
+    const auto z2 = mulMagnitude(a1, b1);
+    const auto sums = mulMagnitude(addMagnitude(a0, a1), addMagnitude(b0, b1));
+    const auto z1 = subMagnitude(subMagnitude(sums, z0), z2);
+
+    Limbs result(a.size() + b.size() + 1);
+    addShifted(result, z0, 0);
+    addShifted(result, z1, half);
+    addShifted(result, z2, 2 * half);
+    trim(result);
+    return result;
+}
+
+/// Divide by a single limb, returning the remainder
+static uint32_t divideByLimb(Limbs& limbs, const uint32_t divisor) {
+    uint64_t remainder = 0;
+    for (size_t i = limbs.size(); i-- > 0;) {
+        const uint64_t current = (remainder << 32) | limbs[i];
+        limbs[i] = static_cast<uint32_t>(current / divisor);
+        remainder = current % divisor;
+    }
+    trim(limbs);
+    return static_cast<uint32_t>(remainder);
+}
+
+static void mulAddLimb(Limbs& limbs, const uint32_t factor, const uint32_t addend) {
+    uint64_t carry = addend;
+    for (auto& limb : limbs) {
+        const uint64_t product = static_cast<uint64_t>(limb) * factor + carry;
+        limb = static_cast<uint32_t>(product);
+        carry = product >> 32;
+    }
+    if (carry != 0) {
+        limbs.push_back(static_cast<uint32_t>(carry));
+    }
+}
+
+/**
+ * Long division of magnitudes, algorithm D of Knuth's TAOCP 4.3.1
+ */
+static std::pair<Limbs, Limbs> divideMagnitude(const Limbs& u, const Limbs& v) {
+    if (compareMagnitude(u, v) < 0) {
+        return {{}, u};
+    }
+    if (v.size() == 1) {
+        auto quotient = u;
+        const auto remainder = divideByLimb(quotient, v[0]);
+        return {quotient, remainder == 0 ? Limbs{} : Limbs{remainder}};
+    }
+
+    // normalize so that the top limb of the divisor has its high bit set
+    const int shift = std::countl_zero(v.back());
+    const auto shifted = [shift](const Limbs& x, const size_t size) {
+        Limbs result(size);
+        for (size_t i = 0; i < x.size(); i++) {
+            const uint64_t limb = static_cast<uint64_t>(x[i]) << shift;
+            result[i] |= static_cast<uint32_t>(limb);
+            if (i + 1 < size) {
+                result[i + 1] |= static_cast<uint32_t>(limb >> 32);
+            }
+        }
+        return result;
+    };
+    const size_t n = v.size();
+    const size_t m = u.size() - n;
+    const auto vn = shifted(v, n);
+    auto un = shifted(u, u.size() + 1);
+
+    Limbs quotient(m + 1);
+    for (size_t j = m + 1; j-- > 0;) {
+        const uint64_t top = (static_cast<uint64_t>(un[j + n]) << 32) | un[j + n - 1];
+        uint64_t qhat = top / vn[n - 1];
+        uint64_t rhat = top % vn[n - 1];
+        while (qhat >= LIMB_BASE || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2])) {
+            qhat--;
+            rhat += vn[n - 1];
+            if (rhat >= LIMB_BASE) {
+                break;
+            }
+        }
+
+        // subtract qhat * vn from the current window of un
+        int64_t borrow = 0;
+        for (size_t i = 0; i < n; i++) {
+            const uint64_t product = qhat * vn[i];
+            const int64_t diff = static_cast<int64_t>(un[i + j]) - borrow -
+                                 static_cast<int64_t>(product & 0xFFFFFFFF);
+            un[i + j] = static_cast<uint32_t>(diff);
+            borrow = static_cast<int64_t>(product >> 32) - (diff >> 32);
+        }
+        const int64_t diff = static_cast<int64_t>(un[j + n]) - borrow;
+        un[j + n] = static_cast<uint32_t>(diff);
+
+        // qhat was one too large, add the divisor back
+        if (diff < 0) {
+            qhat--;
+            uint64_t carry = 0;
+            for (size_t i = 0; i < n; i++) {
+                const uint64_t sum = static_cast<uint64_t>(un[i + j]) + vn[i] + carry;
+                un[i + j] = static_cast<uint32_t>(sum);
+                carry = sum >> 32;
+            }
+            un[j + n] += static_cast<uint32_t>(carry);
+        }
+        quotient[j] = static_cast<uint32_t>(qhat);
+    }
+
+    Limbs remainder(n);
+    for (size_t i = 0; i < n; i++) {
+        remainder[i] = shift == 0 ? un[i] : (un[i] >> shift) | (un[i + 1] << (32 - shift));
+    }
+    trim(quotient);
+    trim(remainder);
+    return {quotient, remainder};
+}
+
+BigInt::BigInt(const bool negative, Limbs limbs) : negative{negative}, limbs(std::move(limbs)) {
+    trim(this->limbs);
+    if (this->limbs.empty()) {
+        this->negative = false;
+    }
+}
+
+BigInt::BigInt(const int64_t value) : negative{value < 0} {
+    // the magnitude of INT64_MIN does not fit in an int64_t
+    const uint64_t magnitude =
+        value < 0 ? uint64_t{0} - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    limbs = {static_cast<uint32_t>(magnitude), static_cast<uint32_t>(magnitude >> 32)};
+    trim(limbs);
+}
+
+BigInt BigInt::fromDouble(double value) {
+    const bool negative = value < 0;
+    value = std::abs(value);
+    Limbs limbs;
+    while (value >= 1) {
+        const double limb = std::fmod(value, static_cast<double>(LIMB_BASE));
+        limbs.push_back(static_cast<uint32_t>(limb));
+        value = (value - limb) / static_cast<double>(LIMB_BASE);
+    }
+    return {negative, std::move(limbs)};
+}
+
+std::optional<BigInt> BigInt::parse(const std::string& text) {
+    size_t start = 0;
+    const bool negative = !text.empty() && text[0] == '-';
+    if (!text.empty() && (text[0] == '-' || text[0] == '+')) {
+        start = 1;
+    }
+    if (start == text.size() ||
+        !std::all_of(text.begin() + static_cast<ptrdiff_t>(start), text.end(),
+                     [](const char c) { return c >= '0' && c <= '9'; })) {
+        return std::nullopt;
+    }
+    // nine decimal digits at a time fit in a limb
+    Limbs limbs;
+    for (size_t pos = start; pos < text.size(); pos += 9) {
+        const size_t count = std::min<size_t>(9, text.size() - pos);
+        uint32_t factor = 1;
+        for (size_t i = 0; i < count; i++) {
+            factor *= 10;
+        }
+        mulAddLimb(limbs, factor, static_cast<uint32_t>(std::stoul(text.substr(pos, count))));
+    }
+    return BigInt{negative, std::move(limbs)};
+}
+
+bool BigInt::isNegative() const {
+    return negative;
+}
+
+bool BigInt::isZero() const {
+    return limbs.empty();
+}
+
+bool BigInt::isOdd() const {
+    return !limbs.empty() && (limbs[0] & 1) != 0;
+}
+
+std::optional<int64_t> BigInt::toInt64() const {
+    if (limbs.size() > 2) {
+        return std::nullopt;
+    }
+    uint64_t magnitude = 0;
+    for (size_t i = limbs.size(); i-- > 0;) {
+        magnitude = (magnitude << 32) | limbs[i];
+    }
+    constexpr uint64_t limit = uint64_t{1} << 63;
+    if (!negative && magnitude < limit) {
+        return static_cast<int64_t>(magnitude);
+    }
+    if (negative && magnitude <= limit) {
+        return static_cast<int64_t>(uint64_t{0} - magnitude);
+    }
+    return std::nullopt;
+}
+
+double BigInt::toDouble() const {
+    double result = 0;
+    for (size_t i = limbs.size(); i-- > 0;) {
+        result = result * static_cast<double>(LIMB_BASE) + limbs[i];
+    }
+    return negative ? -result : result;
+}
+
+std::string BigInt::toString() const {
+    if (limbs.empty()) {
+        return "0";
+    }
+    std::vector<uint32_t> chunks;  // nine decimal digits each, least significant first
+    auto magnitude = limbs;
+    while (!magnitude.empty()) {
+        chunks.push_back(divideByLimb(magnitude, 1000000000));
+    }
+    std::string result = negative ? "-" : "";
+    result += std::to_string(chunks.back());
+    for (size_t i = chunks.size() - 1; i-- > 0;) {
+        const auto chunk = std::to_string(chunks[i]);
+        result += std::string(9 - chunk.size(), '0') + chunk;
+    }
+    return result;
+}
+
+size_t BigInt::hash() const {
+    size_t result = negative;
+    for (const auto limb : limbs) {
+        result = result * 31 + limb;
+    }
+    return result;
+}
+
+BigInt BigInt::operator-() const {
+    return {!negative, limbs};
+}
+
+BigInt operator+(const BigInt& a, const BigInt& b) {
+    if (a.negative == b.negative) {
+        return {a.negative, addMagnitude(a.limbs, b.limbs)};
+    }
+    if (compareMagnitude(a.limbs, b.limbs) >= 0) {
+        return {a.negative, subMagnitude(a.limbs, b.limbs)};
+    }
+    return {b.negative, subMagnitude(b.limbs, a.limbs)};
+}
+
+BigInt operator-(const BigInt& a, const BigInt& b) {
+    return a + -b;
+}
+
+BigInt operator*(const BigInt& a, const BigInt& b) {
+    return {a.negative != b.negative, mulMagnitude(a.limbs, b.limbs)};
+}
+
+std::pair<BigInt, BigInt> BigInt::divide(const BigInt& a, const BigInt& b) {
+    auto [quotient, remainder] = divideMagnitude(a.limbs, b.limbs);
+    return {BigInt{a.negative != b.negative, std::move(quotient)},
+            BigInt{a.negative, std::move(remainder)}};
+}
+
+std::strong_ordering operator<=>(const BigInt& a, const BigInt& b) {
+    if (a.negative != b.negative) {
+        return a.negative ? std::strong_ordering::less : std::strong_ordering::greater;
+    }
+    const int magnitude = compareMagnitude(a.limbs, b.limbs);
+    const int result = a.negative ? -magnitude : magnitude;
+    return result <=> 0;
+}
+
+// Fixnum arithmetic reporting overflow instead of wrapping around
+#if defined(__GNUC__) || defined(__clang__)
+static bool addOverflow(const int64_t a, const int64_t b, int64_t& result) {
+    return __builtin_add_overflow(a, b, &result);
+}
+
+static bool subOverflow(const int64_t a, const int64_t b, int64_t& result) {
+    return __builtin_sub_overflow(a, b, &result);
+}
+
+static bool mulOverflow(const int64_t a, const int64_t b, int64_t& result) {
+    return __builtin_mul_overflow(a, b, &result);
+}
+#else
+static bool addOverflow(const int64_t a, const int64_t b, int64_t& result) {
+    if ((b > 0 && a > INT64_MAX - b) || (b < 0 && a < INT64_MIN - b)) {
+        return true;
+    }
+    result = a + b;
+    return false;
+}
+
+static bool subOverflow(const int64_t a, const int64_t b, int64_t& result) {
+    if ((b < 0 && a > INT64_MAX + b) || (b > 0 && a < INT64_MIN + b)) {
+        return true;
+    }
+    result = a - b;
+    return false;
+}
+
+static bool mulOverflow(const int64_t a, const int64_t b, int64_t& result) {
+    const bool overflow = a > 0 ? (b > 0 ? a > INT64_MAX / b : b < INT64_MIN / a)
+                                : (b > 0 ? a < INT64_MIN / b : a != 0 && b < INT64_MAX / a);
+    if (overflow) {
+        return true;
+    }
+    result = a * b;
+    return false;
+}
+#endif
+
+Number::Number(BigInt value) {
+    if (const auto fixnum = value.toInt64()) {
+        this->value = *fixnum;
+    } else {
+        this->value = std::make_shared<const BigInt>(std::move(value));
+    }
+}
+
+const BigInt& Number::bignum() const {
+    return *std::get<std::shared_ptr<const BigInt>>(value);
+}
+
+BigInt Number::toBigInt() const {
+    if (const auto fixnum = asFixnum()) {
+        return BigInt{*fixnum};
+    }
+    return bignum();
+}
+
+std::optional<Number> Number::parseInteger(const std::string& text) {
+    auto integer = BigInt::parse(text);
+    if (!integer) {
+        return std::nullopt;
+    }
+    return Number{std::move(*integer)};
+}
+
+bool Number::isExact() const {
+    return !std::holds_alternative<double>(value);
+}
+
+bool Number::isFixnum() const {
+    return std::holds_alternative<int64_t>(value);
+}
+
+bool Number::isInteger() const {
+    if (const auto flonum = std::get_if<double>(&value)) {
+        return std::isfinite(*flonum) && std::trunc(*flonum) == *flonum;
+    }
+    return true;
+}
+
+bool Number::isZero() const {
+    switch (value.index()) {
+        case 0:
+            return std::get<int64_t>(value) == 0;
+        case 1:
+            return std::get<double>(value) == 0;
+        default:
+            return false;  // bignums are never small enough
+    }
+}
+
+bool Number::isOdd() const {
+    switch (value.index()) {
+        case 0:
+            return (std::get<int64_t>(value) & 1) != 0;
+        case 1:
+            return std::abs(std::fmod(std::get<double>(value), 2)) == 1;
+        default:
+            return bignum().isOdd();
+    }
+}
+
+std::optional<int64_t> Number::asFixnum() const {
+    if (const auto fixnum = std::get_if<int64_t>(&value)) {
+        return *fixnum;
+    }
+    return std::nullopt;
+}
+
+double Number::toDouble() const {
+    switch (value.index()) {
+        case 0:
+            return static_cast<double>(std::get<int64_t>(value));
+        case 1:
+            return std::get<double>(value);
+        default:
+            return bignum().toDouble();
+    }
+}
+
+std::string Number::toString() const {
+    switch (value.index()) {
+        case 0:
+            return std::to_string(std::get<int64_t>(value));
+        case 1:
+            break;
+        default:
+            return bignum().toString();
+    }
+    auto result = std::to_string(std::get<double>(value));
+    if (result.find('.') != std::string::npos) {
+        result.erase(result.find_last_not_of('0') + 1);
+        if (result.back() == '.') {
+            result.pop_back();
+        }
+    }
+    return result;
+}
+
+size_t Number::hash() const {
+    switch (value.index()) {
+        case 0:
+            return std::hash<int64_t>{}(std::get<int64_t>(value));
+        case 1:
+            return std::hash<double>{}(std::get<double>(value));
+        default:
+            return bignum().hash();
+    }
+}
+
+bool Number::same(const Number& other) const {
+    return isExact() == other.isExact() && *this == other;
+}
+
+Number Number::toExact() const {
+    const auto flonum = std::get_if<double>(&value);
+    if (flonum == nullptr) {
+        return *this;
+    }
+    if (!isInteger()) {
+        throw ValueError(std::format("{} has no exact representation", toString()), std::nullopt);
+    }
+    constexpr double limit = 9223372036854775808.0;  // 2^63
+    if (*flonum >= -limit && *flonum < limit) {
+        return static_cast<int64_t>(*flonum);
+    }
+    return BigInt::fromDouble(*flonum);
+}
+
+Number Number::toInexact() const {
+    return toDouble();
+}
+
+Number Number::abs() const {
+    return *this < 0 ? -*this : *this;
+}
+
+Number Number::expt(const Number& exponent) const {
+    const auto power = exponent.asFixnum();
+    if (!isExact() || !power || *power < 0) {
+        return std::pow(toDouble(), exponent.toDouble());
+    }
+    // exponentiation by squaring stays exact
+    Number result = 1;
+    Number base = *this;
+    for (auto n = *power; n > 0; n >>= 1) {
+        if (n & 1) {
+            result = result * base;
+        }
+        if (n > 1) {
+            base = base * base;
+        }
+    }
+    return result;
+}
+
+Number Number::operator-() const {
+    return Number{0} - *this;
+}
+
+Number operator+(const Number& a, const Number& b) {
+    if (a.isFixnum() && b.isFixnum()) {
+        int64_t result;
+        if (!addOverflow(std::get<int64_t>(a.value), std::get<int64_t>(b.value), result)) {
+            return result;
+        }
+    } else if (!a.isExact() || !b.isExact()) {
+        return a.toDouble() + b.toDouble();
+    }
+    return a.toBigInt() + b.toBigInt();
+}
+
+Number operator-(const Number& a, const Number& b) {
+    if (a.isFixnum() && b.isFixnum()) {
+        int64_t result;
+        if (!subOverflow(std::get<int64_t>(a.value), std::get<int64_t>(b.value), result)) {
+            return result;
+        }
+    } else if (!a.isExact() || !b.isExact()) {
+        return a.toDouble() - b.toDouble();
+    }
+    return a.toBigInt() - b.toBigInt();
+}
+
+Number operator*(const Number& a, const Number& b) {
+    if (a.isFixnum() && b.isFixnum()) {
+        int64_t result;
+        if (!mulOverflow(std::get<int64_t>(a.value), std::get<int64_t>(b.value), result)) {
+            return result;
+        }
+    } else if (!a.isExact() || !b.isExact()) {
+        return a.toDouble() * b.toDouble();
+    }
+    return a.toBigInt() * b.toBigInt();
+}
+
+Number operator/(const Number& a, const Number& b) {
+    if (!a.isExact() || !b.isExact()) {
+        return a.toDouble() / b.toDouble();
+    }
+    if (b.isZero()) {
+        throw ValueError("Division by zero", std::nullopt);
+    }
+    // without rationals, an inexact quotient is the best approximation
+    const auto remainder = Number::remainder(a, b);
+    if (!remainder.isZero()) {
+        return a.toDouble() / b.toDouble();
+    }
+    return Number::quotient(a, b);
+}
+
+Number Number::quotient(const Number& a, const Number& b) {
+    if (b.isZero()) {
+        throw ValueError("Division by zero", std::nullopt);
+    }
+    if (a.isFixnum() && b.isFixnum()) {
+        const auto x = std::get<int64_t>(a.value);
+        const auto y = std::get<int64_t>(b.value);
+        if (x != INT64_MIN || y != -1) {
+            return x / y;
+        }
+    }
+    return BigInt::divide(a.toBigInt(), b.toBigInt()).first;
+}
+
+Number Number::remainder(const Number& a, const Number& b) {
+    if (b.isZero()) {
+        throw ValueError("Division by zero", std::nullopt);
+    }
+    if (a.isFixnum() && b.isFixnum()) {
+        const auto y = std::get<int64_t>(b.value);
+        return y == -1 ? 0 : std::get<int64_t>(a.value) % y;
+    }
+    return BigInt::divide(a.toBigInt(), b.toBigInt()).second;
+}
+
+Number Number::modulo(const Number& a, const Number& b) {
+    auto result = remainder(a, b);
+    if (!result.isZero() && (result < 0) != (b < 0)) {
+        result = result + b;
+    }
+    return result;
+}
+
+/**
+ * Compare an exact integer with a flonum. Rounding the integer to a double could make different
+ * numbers equal, e.g. 2^53 + 1 and 2^53, so the integral part of a finite flonum is converted to an
+ * exact integer instead, and its fraction decides if the integers are equal.
+ */
+static std::partial_ordering compareMixed(const Number& exact, const double flonum) {
+    constexpr int64_t exactDoubles = int64_t{1} << std::numeric_limits<double>::digits;
+    if (const auto fixnum = exact.asFixnum();
+        fixnum.has_value() && *fixnum >= -exactDoubles && *fixnum <= exactDoubles) {
+        return static_cast<double>(*fixnum) <=> flonum;
+    }
+    if (std::isnan(flonum)) {
+        return std::partial_ordering::unordered;
+    }
+    if (std::isinf(flonum)) {
+        return flonum > 0 ? std::partial_ordering::less : std::partial_ordering::greater;
+    }
+    const double whole = std::trunc(flonum);
+    if (const auto order = exact <=> Number(whole).toExact(); order != 0) {
+        return order;
+    }
+    return whole <=> flonum;
+}
+
+std::partial_ordering operator<=>(const Number& a, const Number& b) {
+    if (a.isFixnum() && b.isFixnum()) {
+        return std::get<int64_t>(a.value) <=> std::get<int64_t>(b.value);
+    }
+    if (!a.isExact() && !b.isExact()) {
+        return std::get<double>(a.value) <=> std::get<double>(b.value);
+    }
+    if (!a.isExact() || !b.isExact()) {
+        return a.isExact() ? compareMixed(a, std::get<double>(b.value))
+                           : 0 <=> compareMixed(b, std::get<double>(a.value));
+    }
+    return a.toBigInt() <=> b.toBigInt();
+}
+
+bool operator==(const Number& a, const Number& b) {
+    return (a <=> b) == std::partial_ordering::equivalent;
+}
@@ -0,0 +1,137 @@
+#ifndef NUMBER_H
+#define NUMBER_H
+
+#include <compare>
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+/**
+ * Arbitrary precision integer, a sign and a magnitude in base 2^32. It is only used for the
+ * integers that do not fit in a fixnum, see `Number`.
+ */
+class BigInt {
+public:
+    using Limbs = std::vector<uint32_t>;  // least significant first, without leading zeros
+
+    /// Operands with at least this many limbs are multiplied with Karatsuba's algorithm
+    static constexpr size_t KARATSUBA_THRESHOLD = 32;
+
+private:
+    bool negative = false;
+    Limbs limbs;
+
+    BigInt(bool negative, Limbs limbs);
+
+public:
+    BigInt() = default;
+    explicit BigInt(int64_t value);
+
+    /**
+     * The integer with the value of an integral double
+     */
+    static BigInt fromDouble(double value);
+
+    /**
+     * Parse a decimal integer with an optional sign
+     */
+    static std::optional<BigInt> parse(const std::string& text);
+
+    bool isNegative() const;
+    bool isZero() const;
+    bool isOdd() const;
+
+    std::optional<int64_t> toInt64() const;
+    double toDouble() const;
+    std::string toString() const;
+    size_t hash() const;
+
+    BigInt operator-() const;
+    friend BigInt operator+(const BigInt& a, const BigInt& b);
+    friend BigInt operator-(const BigInt& a, const BigInt& b);
+    friend BigInt operator*(const BigInt& a, const BigInt& b);
+
+    /**
+     * Truncating division
+     * @return the quotient, rounded toward zero, and the remainder, which has the sign of `a`
+     */
+    static std::pair<BigInt, BigInt> divide(const BigInt& a, const BigInt& b);
+
+    friend std::strong_ordering operator<=>(const BigInt& a, const BigInt& b);
+    friend bool operator==(const BigInt& a, const BigInt& b) = default;
+};
+
+/**
+ * A number of the numeric tower. Exact integers are fixnums, i.e. plain 64-bit integers, and are
+ * promoted to bignums when an operation overflows; bignums are demoted again when a result fits.
+ * Inexact numbers are flonums, i.e. doubles. Operations on exact integers stay exact, mixing in a
+ * flonum makes the result inexact.
+ */
+class Number {
+    std::variant<int64_t, double, std::shared_ptr<const BigInt>> value;
+
+    const BigInt& bignum() const;
+    BigInt toBigInt() const;
+
+public:
+    template <std::integral T>
+    Number(T value) : value{static_cast<int64_t>(value)} {}
+    Number(double value) : value{value} {}
+    Number(BigInt value);
+
+    /**
+     * Parse an integer literal, which is exact however large it is
+     * @return the number, or nullopt if the text is not an integer literal
+     */
+    static std::optional<Number> parseInteger(const std::string& text);
+
+    bool isExact() const;
+    bool isFixnum() const;
+    /// Whether the number is an exact integer or an integral flonum
+    bool isInteger() const;
+    bool isZero() const;
+    /// Whether an integer is odd, flonums are converted to an integer first
+    bool isOdd() const;
+
+    /// The fixnum, or nullopt for bignums and flonums
+    std::optional<int64_t> asFixnum() const;
+    double toDouble() const;
+    std::string toString() const;
+    size_t hash() const;
+
+    /**
+     * Whether two numbers are the same, i.e. numerically equal and both exact or both inexact, like
+     * `eqv?` compares them
+     */
+    bool same(const Number& other) const;
+
+    Number toExact() const;
+    Number toInexact() const;
+    Number abs() const;
+    Number expt(const Number& exponent) const;
+
+    Number operator-() const;
+    friend Number operator+(const Number& a, const Number& b);
+    friend Number operator-(const Number& a, const Number& b);
+    friend Number operator*(const Number& a, const Number& b);
+    /// Exact if both operands are exact and the division leaves no remainder
+    friend Number operator/(const Number& a, const Number& b);
+
+    /// Integer division of exact integers, rounded toward zero
+    static Number quotient(const Number& a, const Number& b);
+    /// Remainder of `quotient`, with the sign of `a`
+    static Number remainder(const Number& a, const Number& b);
+    /// Remainder with the sign of `b`
+    static Number modulo(const Number& a, const Number& b);
+
+    /// Numeric comparison, regardless of exactness
+    friend std::partial_ordering operator<=>(const Number& a, const Number& b);
+    friend bool operator==(const Number& a, const Number& b);
+};
+
+#endif  // NUMBER_H
@@ -21,11 +21,28 @@
             instance->makeValue<PairValue>(this->parse(), instance->makeValue<NilValue>())); \
     }
 
+size_t Parser::maxDepth = 10000;
+
 Parser::Parser(std::deque<TokenPtr> tokens) : tokens(std::move(tokens)) {}
 
 ValuePtr Parser::parse() {
     const TokenPtr token = std::move(tokens.front());
     tokens.pop_front();
+    if (depth >= maxDepth) {
+        throw SyntaxError(std::format("Maximum nesting depth ({}) exceeded", maxDepth),
+                          token->getLocation());
+    }
+    if (nativeStackExhausted()) {
+        throw SyntaxError(std::format("Nesting too deep for the native stack at depth {}", depth),
+                          token->getLocation());
+    }
+    depth++;
+    struct DepthGuard {
+        size_t& depth;
+        ~DepthGuard() {
+            depth--;
+        }
+    } guard{depth};
 
     RETURN_VALUE_IF_MATCH(token, NumericLiteralToken, NumericValue);
     RETURN_VALUE_IF_MATCH(token, BooleanLiteralToken, BooleanValue);
@@ -55,40 +72,39 @@ bool Parser::empty() const {
 }
 
 ValuePtr Parser::parseTails() {
-    if (tokens.empty()) {
-        throw SyntaxError("Expected ')'", std::nullopt);
-    }
-
-    auto frontTy = tokens.front()->getType();
-
-    // find right parenthesis, return nil
-    if (frontTy == TokenType::RIGHT_PAREN) {
-        tokens.pop_front();
-        return LISP_NIL;
-    }
-
-    auto car = this->parse();
+    // the elements are parsed in a loop instead of recursing once per element, so the C++ stack
+    // only grows with the nesting depth of the list
+    ListBuilder builder;
+    while (true) {
+        if (tokens.empty()) {
+            throw SyntaxError("Expected ')'", std::nullopt);
+        }
 
-    if (tokens.empty()) {
-        throw SyntaxError("Expected ')'", std::nullopt);
-    }
+        const auto frontTy = tokens.front()->getType();
 
-    frontTy = tokens.front()->getType();
+        // find right parenthesis, the list ends with nil
+        if (frontTy == TokenType::RIGHT_PAREN) {
+            tokens.pop_front();
+            return builder.build();
+        }
 
-    // check if the next token is a dot, if it is, parse the cdr
-    if (frontTy == TokenType::DOT) {
-        tokens.pop_front();
-        auto cdr = this->parse();
+        // check if the next token is a dot, if it is, parse the cdr
+        if (frontTy == TokenType::DOT && !builder.empty()) {
+            tokens.pop_front();
+            auto cdr = this->parse();
 
-        // check the end token, if it is not a right parenthesis, throw an error
-        const TokenPtr endToken = std::move(tokens.front());
-        tokens.pop_front();
-        if (endToken->getType() != TokenType::RIGHT_PAREN) {
-            throw SyntaxError("Expected ')' at the end of the list", std::nullopt);
+            // check the end token, if it is not a right parenthesis, throw an error
+            if (tokens.empty()) {
+                throw SyntaxError("Expected ')'", std::nullopt);
+            }
+            const TokenPtr endToken = std::move(tokens.front());
+            tokens.pop_front();
+            if (endToken->getType() != TokenType::RIGHT_PAREN) {
+                throw SyntaxError("Expected ')' at the end of the list", std::nullopt);
+            }
+            return builder.build(cdr);
         }
-        return LISP_PAIR(car, cdr);
-    }
 
-    auto cdr = this->parseTails();
-    return LISP_PAIR(car, cdr);
+        builder.push(this->parse());
+    }
 }
@@ -1,6 +1,7 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include <cstddef>
 #include <deque>
 #include <memory>
 
@@ -12,12 +13,20 @@ using TokenPtr = std::unique_ptr<Token>;
 
 class Parser {
     std::deque<TokenPtr> tokens;
+    size_t depth = 0;
 
     ValuePtr parseTails();
 
 public:
     explicit Parser(std::deque<TokenPtr> tokens);
 
+    /**
+     * Maximum nesting depth of the data parsed, set by LISP_MAX_DEPTH like EvalEnv::maxDepth.
+     * Deeper input raises a SyntaxError, and so does running out of native stack before reaching
+     * the limit.
+     */
+    static size_t maxDepth;
+
     ValuePtr parse();
     bool empty() const;
 };
@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <ranges>
+#include <unordered_set>
 
 #include "builtins.h"
 #include "eval_env.h"
@@ -33,54 +34,69 @@ EvalEnv* ValuePool::makeEnv(const EvalEnv* parent) {
 size_t ValuePool::gc() {
     size_t count = 0;
 
-    std::set<Value*> reachableValues;
-    std::set<EvalEnv*> reachableEnvs;
+    std::unordered_set<Value*> reachableValues;
+    std::unordered_set<EvalEnv*> reachableEnvs;
     std::vector<Value*> addedValues;
     std::vector<EvalEnv*> addedEnvs;
 
-    // mark available values
-    // first, we start from the root environment
+    // mark available values with explicit work lists rather than recursion, so that long lists
+    // cannot overflow the stack. We start from the root environment
     addedEnvs.push_back(rootEnv);
-    bool found = false;
+    std::ranges::copy(evalCache_.values(), std::back_inserter(addedValues));
 
-    do {
-        found = false;
+    while (!addedEnvs.empty() || !addedValues.empty()) {
         // add new envs to reachableEnvs
         while (!addedEnvs.empty()) {
             auto env = addedEnvs.back();
             addedEnvs.pop_back();
-            reachableEnvs.insert(env);
+            if (!reachableEnvs.insert(env).second) {
+                continue;
+            }
             for (const auto value : std::views::values(env->symbolTable)) {
-                found = true;
                 addedValues.push_back(value);
-                const auto children = value->children();
-                std::ranges::copy(children, std::back_inserter(addedValues));
+            }
+            for (const auto value : env->slots) {
+                if (value != nullptr) {
+                    addedValues.push_back(value);
+                }
+            }
+            // closures keep the whole chain of enclosing environments alive
+            if (env->parent != nullptr) {
+                addedEnvs.push_back(const_cast<EvalEnv*>(env->parent));
             }
         }
         // add new values to reachableValues, if they are lambdas, add their envs to addedEnvs
         while (!addedValues.empty()) {
             Value* value = addedValues.back();
             addedValues.pop_back();
-            if (value == &nil) {
+            if (value == MultipleValues::getMarker()) {
+                // a static value, but what it stands for lives in the pool
+                std::ranges::copy(value->children(), std::back_inserter(addedValues));
                 continue;
             }
-            reachableValues.insert(value);
+            if (value == &nil || !reachableValues.insert(value).second) {
+                continue;
+            }
+            std::ranges::copy(value->children(), std::back_inserter(addedValues));
+            if (value->getType() == ValueType::PAIR && !codeCaches.empty()) {
+                if (const auto it = codeCaches.find(static_cast<PairValue*>(value));
+                    it != codeCaches.end()) {
+                    std::ranges::copy(it->second->children(), std::back_inserter(addedValues));
+                }
+            }
             if (value->getType() == ValueType::LAMBDA) {
-                const auto lambda = dynamic_cast<LambdaValue*>(value);
+                const auto lambda = static_cast<LambdaValue*>(value);
                 if (!reachableEnvs.contains(lambda->env)) {
                     addedEnvs.push_back(lambda->env);
                 }
-                for (const auto v : lambda->body) {
-                    addedValues.push_back(v);
-                    const auto children = v->children();
-                    std::ranges::copy(children, std::back_inserter(addedValues));
-                }
-                found = true;
             }
         }
-    } while (found);
+    }
 
-    // remove unreachable values
+    // remove unreachable values, and what was cached for them as code
+    std::erase_if(codeCaches, [&](const auto& entry) {
+        return !reachableValues.contains(const_cast<PairValue*>(entry.first));
+    });
     while (!values.empty()) {
         auto value = values.back();
         values.pop_back();
@@ -116,6 +132,19 @@ EvalEnv* ValuePool::root() const {
     return rootEnv;
 }
 
+EvalCache& ValuePool::evalCache() {
+    return evalCache_;
+}
+
+CodeCache* ValuePool::codeCache(const PairValue* code) const {
+    const auto it = codeCaches.find(code);
+    return it == codeCaches.end() ? nullptr : it->second.get();
+}
+
+void ValuePool::setCodeCache(const PairValue* code, std::shared_ptr<CodeCache> cache) {
+    codeCaches[code] = std::move(cache);
+}
+
 ValuePool* ValuePool::instance() {
     if (!instance_) {
         instance_ = new ValuePool();
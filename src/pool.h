@@ -2,13 +2,18 @@
 #define GC_H
 
 #include <concepts>
+#include <memory>
+#include <unordered_map>
 
+#include "eval_cache.h"
 #include "value.h"
 
 class ValuePool {
     std::vector<Value*> values;
     std::vector<EvalEnv*> envs;
     EvalEnv* rootEnv;
+    EvalCache evalCache_;
+    std::unordered_map<const PairValue*, std::shared_ptr<CodeCache>> codeCaches;
 
     static NilValue nil;
     ValuePool();
@@ -32,6 +37,15 @@ public:
 
     EvalEnv* root() const;
 
+    EvalCache& evalCache();
+
+    /**
+     * Data cached for a pair evaluated as code, see CodeCache. It lives as long as the pair.
+     * @return the data, or nullptr if there is none
+     */
+    CodeCache* codeCache(const PairValue* code) const;
+    void setCodeCache(const PairValue* code, std::shared_ptr<CodeCache> cache);
+
     static ValuePool* instance();
     static void dispose();
 };
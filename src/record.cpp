@@ -0,0 +1,116 @@
+#include "record.h"
+
+#include <format>
+#include <sstream>
+
+#include "error.h"
+#include "pool.h"
+#include "utils.h"
+
+std::string RecordTypeValue::getName() const {
+    if (name.size() > 2 && name.front() == '<' && name.back() == '>') {
+        return name.substr(1, name.size() - 2);
+    }
+    return name;
+}
+
+const std::vector<std::string>& RecordTypeValue::getFields() const {
+    return fields;
+}
+
+std::string RecordTypeValue::toString() const {
+    return std::format("#<record-type {}>", getName());
+}
+
+bool RecordTypeValue::equals(const ValuePtr& other) const {
+    return this == other;
+}
+
+RecordValue::RecordValue(RecordTypeValue* type, const std::optional<Location>& location)
+    : Value(ValueType::RECORD, location),
+      type{type},
+      slots(std::make_unique<ValuePtr[]>(type->getFields().size())) {
+    for (size_t i = 0; i < type->getFields().size(); i++) {
+        slots[i] = LISP_NIL;
+    }
+}
+
+RecordTypeValue* RecordValue::getRecordType() const {
+    return type;
+}
+
+ValuePtr RecordValue::getSlot(const size_t offset) const {
+    return slots[offset];
+}
+
+void RecordValue::setSlot(const size_t offset, ValuePtr value) {
+    slots[offset] = value;
+}
+
+std::string RecordValue::toString() const {
+    std::stringstream ss;
+    ss << "#<" << type->getName();
+    const auto& fields = type->getFields();
+    for (size_t i = 0; i < fields.size(); i++) {
+        ss << " " << fields[i] << ": " << slots[i]->toString();
+    }
+    ss << ">";
+    return ss.str();
+}
+
+bool RecordValue::equals(const ValuePtr& other) const {
+    return this == other;
+}
+
+std::vector<ValuePtr> RecordValue::children() const {
+    std::vector<ValuePtr> result{type};
+    result.insert(result.end(), slots.get(), slots.get() + type->getFields().size());
+    return result;
+}
+
+RecordValue* RecordProcValue::checkRecord(const ValuePtr& value) const {
+    if (value->getType() != ValueType::RECORD ||
+        static_cast<RecordValue*>(value)->getRecordType() != type) {
+        throw TypeError(std::format("{} requires a {} record as its argument", name,
+                                    type->getName()),
+                        value->getLocation());
+    }
+    return static_cast<RecordValue*>(value);
+}
+
+ValuePtr RecordProcValue::apply(const std::vector<ValuePtr>& args) const {
+    const size_t expected = kind == Kind::CONSTRUCTOR ? offsets.size()
+                            : kind == Kind::MODIFIER  ? 2
+                                                      : 1;
+    if (args.size() != expected) {
+        throw ValueError(
+            std::format("{}: expected {} arguments, but got {}", name, expected, args.size()),
+            Location::fromRange(args));
+    }
+    switch (kind) {
+        case Kind::CONSTRUCTOR: {
+            const auto record = ValuePool::instance()->makeValue<RecordValue>(type);
+            for (size_t i = 0; i < offsets.size(); i++) {
+                record->setSlot(offsets[i], args[i]);
+            }
+            return record;
+        }
+        case Kind::PREDICATE:
+            return LISP_BOOL(args[0]->getType() == ValueType::RECORD &&
+                             static_cast<RecordValue*>(args[0])->getRecordType() == type);
+        case Kind::ACCESSOR:
+            return checkRecord(args[0])->getSlot(offsets.front());
+        case Kind::MODIFIER:
+            checkRecord(args[0])->setSlot(offsets.front(), args[1]);
+            return LISP_NIL;
+    }
+    throw InternalError("This is a bug, not your fault, please report it", std::nullopt);
+}
+
+bool RecordProcValue::equals(const ValuePtr& other) const {
+    return this == other;
+}
+
+std::vector<ValuePtr> RecordProcValue::children() const {
+    return {type};
+}
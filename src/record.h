@@ -0,0 +1,92 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "value.h"
+
+/**
+ * Type descriptor of the records defined by a `define-record-type`
+ */
+class RecordTypeValue : public Value {
+    std::string name;
+    std::vector<std::string> fields;
+
+public:
+    RecordTypeValue(std::string name, std::vector<std::string> fields,
+                    const std::optional<Location>& location = std::nullopt)
+        : Value(ValueType::RECORD_TYPE, location),
+          name(std::move(name)),
+          fields(std::move(fields)) {}
+
+    /// The type name without the conventional angle brackets, i.e. `point` for `<point>`
+    std::string getName() const;
+    const std::vector<std::string>& getFields() const;
+
+    std::string toString() const override;
+    bool equals(const ValuePtr& other) const override;
+};
+
+/**
+ * An instance of a record type. Its fields are stored in one slot array, in the order of the type
+ * descriptor, so a record takes a single allocation besides the value itself instead of a pair for
+ * every field.
+ */
+class RecordValue : public Value {
+    RecordTypeValue* type;
+    std::unique_ptr<ValuePtr[]> slots;
+
+public:
+    /// Create a record with every field set to nil
+    explicit RecordValue(RecordTypeValue* type,
+                         const std::optional<Location>& location = std::nullopt);
+
+    RecordTypeValue* getRecordType() const;
+    ValuePtr getSlot(size_t offset) const;
+    void setSlot(size_t offset, ValuePtr value);
+
+    std::string toString() const override;
+    bool equals(const ValuePtr& other) const override;
+    std::vector<ValuePtr> children() const override;
+};
+
+/**
+ * A constructor, predicate, accessor or modifier generated by `define-record-type`. Field names
+ * are resolved to slot offsets when the record type is defined, so a call only checks the type of
+ * the record before reading or writing the slot.
+ */
+class RecordProcValue : public BuiltinProcValue {
+public:
+    enum class Kind {
+        CONSTRUCTOR,
+        PREDICATE,
+        ACCESSOR,
+        MODIFIER,
+    };
+
+private:
+    Kind kind;
+    RecordTypeValue* type;
+    std::string name;
+    std::vector<size_t> offsets;  // slots of the constructor arguments, or the accessed slot
+
+    RecordValue* checkRecord(const ValuePtr& value) const;
+
+public:
+    RecordProcValue(Kind kind, RecordTypeValue* type, std::string name,
+                    std::vector<size_t> offsets,
+                    const std::optional<Location>& location = std::nullopt)
+        : BuiltinProcValue(nullptr, location),
+          kind{kind},
+          type{type},
+          name(std::move(name)),
+          offsets(std::move(offsets)) {}
+
+    ValuePtr apply(const std::vector<ValuePtr>& args) const override;
+    bool equals(const ValuePtr& other) const override;
+    std::vector<ValuePtr> children() const override;
+};
+
+#endif  // RECORD_H
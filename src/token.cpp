@@ -69,7 +69,7 @@ std::string BooleanLiteralToken::toString() const {
 }
 
 std::string NumericLiteralToken::toString() const {
-    return "(NUMERIC_LITERAL " + std::to_string(value) + ")";
+    return "(NUMERIC_LITERAL " + value.toString() + ")";
 }
 
 std::string StringLiteralToken::toString() const {
@@ -5,6 +5,7 @@
 #include <string>
 
 #include "location.h"
+#include "number.h"
 
 enum class TokenType {
     LEFT_PAREN,
@@ -72,13 +73,13 @@ public:
 };
 
 class NumericLiteralToken : public Token {
-    double value;
+    Number value;
 
 public:
-    explicit NumericLiteralToken(double value, const std::string& file, int row, int col, int len)
-        : Token(TokenType::NUMERIC_LITERAL, file, row, col, len), value{value} {}
+    explicit NumericLiteralToken(Number value, const std::string& file, int row, int col, int len)
+        : Token(TokenType::NUMERIC_LITERAL, file, row, col, len), value(std::move(value)) {}
 
-    double getValue() const {
+    const Number& getValue() const {
         return value;
     }
     std::string toString() const override;
@@ -66,6 +66,11 @@ TokenPtr Tokenizer::nextToken(int& pos) const {
                 return Token::dot(file, row, pos);
             }
             if (std::isdigit(text[0]) || text[0] == '+' || text[0] == '-' || text[0] == '.') {
+                // integer literals are exact, anything else is read as a double
+                if (auto integer = Number::parseInteger(text)) {
+                    return std::make_unique<NumericLiteralToken>(std::move(*integer), file, row,
+                                                                 start, pos - start);
+                }
                 try {
                     return std::make_unique<NumericLiteralToken>(std::stod(text), file, row, start,
                                                                  pos - start);
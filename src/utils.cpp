@@ -2,6 +2,13 @@
 
 #include <vector>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "pool.h"
 #include "value.h"
 
 void removeTrailingNil(std::vector<ValuePtr>& values) {
@@ -11,4 +18,57 @@ void removeTrailingNil(std::vector<ValuePtr>& values) {
     if (values.back()->getType() == ValueType::NIL) {
         values.pop_back();
     }
-}
\ No newline at end of file
+}
+
+uintptr_t nativeStackLimit() {
+#if defined(_WIN32)
+    ULONG_PTR low = 0;
+    ULONG_PTR high = 0;
+    GetCurrentThreadStackLimits(&low, &high);
+    return low;
+#elif defined(__APPLE__)
+    const auto self = pthread_self();
+    return reinterpret_cast<uintptr_t>(pthread_get_stackaddr_np(self)) -
+           pthread_get_stacksize_np(self);
+#elif defined(__linux__)
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+        return 0;
+    }
+    void* address = nullptr;
+    size_t size = 0;
+    const bool known = pthread_attr_getstack(&attr, &address, &size) == 0;
+    pthread_attr_destroy(&attr);
+    return known ? reinterpret_cast<uintptr_t>(address) : 0;
+#else
+    return 0;
+#endif
+}
+
+ListBuilder::ListBuilder() : head(LISP_NIL) {}
+
+void ListBuilder::push(ValuePtr value) {
+    const auto pair = LISP_PAIR(value, LISP_NIL);
+    if (tail == nullptr) {
+        head = pair;
+    } else {
+        tail->setCdr(pair);
+    }
+    tail = pair;
+}
+
+bool ListBuilder::empty() const {
+    return tail == nullptr;
+}
+
+ValuePtr ListBuilder::build() const {
+    return head;
+}
+
+ValuePtr ListBuilder::build(ValuePtr tail) {
+    if (this->tail == nullptr) {
+        return tail;
+    }
+    this->tail->setCdr(tail);
+    return head;
+}
@@ -1,12 +1,61 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <cstdint>
 #include <deque>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 #include "value.h"
 
 void removeTrailingNil(std::vector<ValuePtr>& values);
 
+/**
+ * The lowest address the native stack of the current thread can grow to, or 0 where it cannot be
+ * determined
+ */
+uintptr_t nativeStackLimit();
+
+/// Native stack kept free for the code running between two checks of `nativeStackExhausted`
+constexpr uintptr_t NATIVE_STACK_RESERVE = 256 * 1024;
+
+/**
+ * Whether the native stack of the current thread is nearly used up. Recursive code checks this to
+ * raise an error instead of overflowing the stack, whatever size the stack has and however large
+ * the frames of the build are.
+ */
+inline bool nativeStackExhausted() {
+    thread_local const uintptr_t limit = nativeStackLimit();
+#ifdef _MSC_VER
+    const auto current = reinterpret_cast<uintptr_t>(_AddressOfReturnAddress());
+#else
+    const auto current = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+#endif
+    return limit != 0 && current < limit + NATIVE_STACK_RESERVE;
+}
+
+/**
+ * Build a proper list front to back, without collecting the elements into a vector first
+ */
+class ListBuilder {
+    ValuePtr head;
+    PairValue* tail = nullptr;
+
+public:
+    ListBuilder();
+
+    void push(ValuePtr value);
+    bool empty() const;
+    ValuePtr build() const;
+
+    /**
+     * Finish an improper list, `tail` becomes the cdr of the last pair
+     */
+    ValuePtr build(ValuePtr tail);
+};
+
 template <typename T>
 std::deque<T> merge(std::deque<T> a, std::deque<T> b) {
     std::deque<T> result;
@@ -1,5 +1,6 @@
 #include "value.h"
 
+#include <algorithm>
 #include <format>
 #include <iomanip>
 #include <ranges>
@@ -7,6 +8,7 @@
 
 #include "error.h"
 #include "eval_env.h"
+#include "forms.h"
 #include "pool.h"
 #include "utils.h"
 
@@ -26,7 +28,7 @@ ValueType Value::getType() const {
 
 std::optional<std::string> Value::asSymbolName() const {
     if (ty == ValueType::SYMBOL) {
-        auto symbolName = dynamic_cast<const SymbolValue*>(this)->getValue();
+        auto symbolName = static_cast<const SymbolValue*>(this)->getValue();
         return symbolName;
     }
     return std::nullopt;
@@ -38,7 +40,7 @@ bool Value::isNumber() const {
 
 std::optional<double> Value::asNumber() const {
     if (this->isNumber()) {
-        return dynamic_cast<const NumericValue*>(this)->getValue();
+        return static_cast<const NumericValue*>(this)->getValue();
     }
     return std::nullopt;
 }
@@ -51,20 +53,8 @@ const std::optional<Location>& Value::getLocation() const {
     return location;
 }
 
-std::vector<ValuePtr> Value::children() {
-    if (this->getType() != ValueType::PAIR) {
-        return {};
-    }
-    std::vector<ValuePtr> children;
-    auto pair = dynamic_cast<PairValue*>(this);
-    children.push_back(pair->getCar());
-    children.push_back(pair->getCdr());
-
-    auto carChildren = pair->getCar()->children();
-    auto cdrChildren = pair->getCdr()->children();
-    std::ranges::copy(carChildren, std::back_inserter(children));
-    std::ranges::copy(cdrChildren, std::back_inserter(children));
-    return children;
+std::vector<ValuePtr> Value::children() const {
+    return {};
 }
 
 std::string BooleanValue::toString() const {
@@ -83,25 +73,22 @@ bool BooleanValue::equals(const ValuePtr& other) const {
 }
 
 std::string NumericValue::toString() const {
-    auto result = std::to_string(value);
-    if (result.find('.') != std::string::npos) {
-        result.erase(result.find_last_not_of('0') + 1);
-        if (result.back() == '.') {
-            result.pop_back();
-        }
-    }
-    return result;
+    return value.toString();
 }
 
-double NumericValue::getValue() const {
+const Number& NumericValue::getNumber() const {
     return value;
 }
 
+double NumericValue::getValue() const {
+    return value.toDouble();
+}
+
 bool NumericValue::equals(const ValuePtr& other) const {
     if (other->getType() != ValueType::NUMBER) {
         return false;
     }
-    return value == dynamic_cast<NumericValue*>(other)->getValue();
+    return value.same(static_cast<NumericValue*>(other)->getNumber());
 }
 
 std::string StringValue::toString() const {
@@ -121,14 +108,33 @@ bool StringValue::equals(const ValuePtr& other) const {
     return value == dynamic_cast<StringValue*>(other)->getValue();
 }
 
+SymbolValue::SymbolValue(const std::string& value, const std::optional<Location>& location)
+    : Value(ValueType::SYMBOL, location), value{value}, form{nullptr} {
+    if (const auto it = SPECIAL_FORMS.find(value); it != SPECIAL_FORMS.end()) {
+        form = it->second;
+    }
+}
+
 std::string SymbolValue::toString() const {
     return value;
 }
 
-std::string SymbolValue::getValue() const {
+const std::string& SymbolValue::getValue() const {
     return value;
 }
 
+SpecialFormType* SymbolValue::getForm() const {
+    return form;
+}
+
+const SlotAddress& SymbolValue::getAddress() const {
+    return address;
+}
+
+void SymbolValue::setAddress(SlotAddress address) const {
+    this->address = std::move(address);
+}
+
 bool SymbolValue::equals(const ValuePtr& other) const {
     if (other->getType() != ValueType::SYMBOL) {
         return false;
@@ -191,12 +197,48 @@ ValuePtr PairValue::getCdr() const {
     return cdr;
 }
 
+void PairValue::setCar(ValuePtr value) {
+    car = value;
+}
+
+void PairValue::setCdr(ValuePtr value) {
+    cdr = value;
+}
+
 bool PairValue::equals(const ValuePtr& other) const {
-    if (other->getType() != ValueType::PAIR) {
-        return false;
+    // walk along the cdr chain iteratively, so that long lists do not overflow the stack
+    auto current = this;
+    auto otherValue = other;
+    while (true) {
+        if (otherValue->getType() != ValueType::PAIR) {
+            return false;
+        }
+        const auto otherPair = static_cast<PairValue*>(otherValue);
+        if (!current->car->equals(otherPair->car)) {
+            return false;
+        }
+        if (current->cdr->getType() != ValueType::PAIR) {
+            return current->cdr->equals(otherPair->cdr);
+        }
+        current = static_cast<PairValue*>(current->cdr);
+        otherValue = otherPair->cdr;
     }
-    const auto otherPair = dynamic_cast<PairValue*>(other);
-    return car->equals(otherPair->car) && cdr->equals(otherPair->cdr);
+}
+
+CodeCache* PairValue::getCache() const {
+    return ValuePool::instance()->codeCache(this);
+}
+
+void PairValue::setCache(std::shared_ptr<CodeCache> newCache) {
+    ValuePool::instance()->setCodeCache(this, std::move(newCache));
+}
+
+std::vector<ValuePtr> PairValue::children() const {
+    return {car, cdr};
+}
+
+std::vector<ValuePtr> CodeCache::children() const {
+    return {};
 }
 
 std::string BuiltinProcValue::toString() const {
@@ -207,6 +249,10 @@ ValuePtr BuiltinProcValue::apply(const std::vector<ValuePtr>& args) const {
     return func(args);
 }
 
+BuiltinFuncType* BuiltinProcValue::getFunc() const {
+    return func;
+}
+
 bool BuiltinProcValue::equals(const ValuePtr& other) const {
     if (other->getType() != ValueType::BUILTIN) {
         return false;
@@ -216,29 +262,317 @@ bool BuiltinProcValue::equals(const ValuePtr& other) const {
 
 LambdaValue::LambdaValue(std::vector<std::string> params, std::vector<ValuePtr> body, EvalEnv* env,
                          const std::optional<Location>& location)
+    : LambdaValue(frameLayout(params, body), params.size(), RestParam::NONE, std::move(body), env,
+                  location) {}
+
+LambdaValue::LambdaValue(std::shared_ptr<const FrameLayout> layout, const size_t paramCount,
+                         const RestParam rest, std::vector<ValuePtr> body, EvalEnv* env,
+                         const std::optional<Location>& location)
     : Value(ValueType::LAMBDA, location),
-      params(std::move(params)),
+      layout(std::move(layout)),
+      paramCount{paramCount},
+      rest{rest},
+      analyzed{EvalEnv::redefinitions},
       body(std::move(body)),
       env(env) {}
 
+void LambdaValue::escape() const {
+    env->capture();
+}
+
+static void collectDefinitions(const ValuePtr& expr, FrameLayout& names) {
+    if (expr->getType() != ValueType::PAIR) {
+        return;
+    }
+    const auto pair = static_cast<PairValue*>(expr);
+    if (pair->getCar()->getType() != ValueType::SYMBOL ||
+        pair->getCdr()->getType() != ValueType::PAIR) {
+        return;
+    }
+    const auto form = static_cast<SymbolValue*>(pair->getCar())->getForm();
+    const auto operands = static_cast<PairValue*>(pair->getCdr());
+    if (form == &beginForm) {
+        for (ValuePtr current = operands; current->getType() == ValueType::PAIR;
+             current = static_cast<PairValue*>(current)->getCdr()) {
+            collectDefinitions(static_cast<PairValue*>(current)->getCar(), names);
+        }
+    } else if (form == &defineForm) {
+        auto target = operands->getCar();
+        if (target->getType() == ValueType::PAIR) {
+            target = static_cast<PairValue*>(target)->getCar();
+        }
+        if (const auto name = target->asSymbolName();
+            name.has_value() && std::ranges::find(names, *name) == names.end()) {
+            names.push_back(*name);
+        }
+    }
+}
+
+static bool refersTo(const Value* expr, const std::string& name) {
+    while (expr->getType() == ValueType::PAIR) {
+        const auto pair = static_cast<const PairValue*>(expr);
+        if (refersTo(pair->getCar(), name)) {
+            return true;
+        }
+        expr = pair->getCdr();
+    }
+    return expr->getType() == ValueType::SYMBOL &&
+           static_cast<const SymbolValue*>(expr)->getValue() == name;
+}
+
+/**
+ * Whether `expr` calls a macro, whose expansion can refer to any variable without naming it in
+ * `expr`. Variables of the frame are never macros, other names are looked up in `env`.
+ */
+static bool callsMacro(const Value* expr, const FrameLayout& bound, const EvalEnv* env) {
+    if (expr->getType() != ValueType::PAIR) {
+        return false;
+    }
+    if (const auto head = static_cast<const PairValue*>(expr)->getCar();
+        head->getType() == ValueType::SYMBOL) {
+        const auto symbol = static_cast<const SymbolValue*>(head);
+        if (symbol->getForm() == &quoteForm) {
+            return false;
+        }
+        if (symbol->getForm() == nullptr &&
+            std::ranges::find(bound, symbol->getValue()) == bound.end()) {
+            const auto value = env->lookupBinding(symbol->getValue());
+            if (value != nullptr && value->getType() == ValueType::MACRO) {
+                return true;
+            }
+        }
+    }
+    while (expr->getType() == ValueType::PAIR) {
+        const auto pair = static_cast<const PairValue*>(expr);
+        if (callsMacro(pair->getCar(), bound, env)) {
+            return true;
+        }
+        expr = pair->getCdr();
+    }
+    return false;
+}
+
+RestParam LambdaValue::restParam(const std::string& name, const FrameLayout& layout,
+                                 const std::vector<ValuePtr>& body, const EvalEnv* env) {
+    // code passed to `eval` may refer to any variable in scope
+    const auto used = std::ranges::any_of(body, [&](const ValuePtr& expr) {
+        return refersTo(expr, name) || refersTo(expr, "eval") || callsMacro(expr, layout, env);
+    });
+    return used ? RestParam::USED : RestParam::UNUSED;
+}
+
+RestParam LambdaValue::getRestParam() const {
+    if (rest == RestParam::UNUSED && analyzed != EvalEnv::redefinitions) {
+        // a macro defined since the analysis may expand to the rest parameter
+        rest = restParam((*layout)[paramCount], *layout, body, env);
+        analyzed = EvalEnv::redefinitions;
+    }
+    return rest;
+}
+
+/**
+ * Where the references in `expr` are resolved to: the slots of a frame laid out as `layout`, which
+ * is `depth` procedures up from `expr`. The variables of those procedures, `shadowed`, hide the
+ * ones of the frame. `env` is the environment the frame's procedure is created in.
+ */
+struct SlotScope {
+    const std::shared_ptr<const FrameLayout>& layout;
+    size_t depth;
+    FrameLayout shadowed;
+    const EvalEnv* env;
+};
+
+static void resolveSlots(const ValuePtr& expr, const SlotScope& scope);
+
+static void resolveEach(ValuePtr list, const SlotScope& scope) {
+    for (; list->getType() == ValueType::PAIR; list = static_cast<PairValue*>(list)->getCdr()) {
+        resolveSlots(static_cast<PairValue*>(list)->getCar(), scope);
+    }
+}
+
+/// The body of a procedure created in the frame runs in a frame of its own, one level deeper
+static void resolveNested(ValuePtr formals, const ValuePtr& body, const SlotScope& scope) {
+    auto nested = SlotScope{scope.layout, scope.depth + 1, scope.shadowed, scope.env};
+    for (; formals->getType() == ValueType::PAIR;
+         formals = static_cast<PairValue*>(formals)->getCdr()) {
+        if (const auto name = static_cast<PairValue*>(formals)->getCar()->asSymbolName()) {
+            nested.shadowed.push_back(*name);
+        }
+    }
+    if (const auto rest = formals->asSymbolName()) {
+        nested.shadowed.push_back(*rest);
+    }
+    for (auto current = body; current->getType() == ValueType::PAIR;
+         current = static_cast<PairValue*>(current)->getCdr()) {
+        collectDefinitions(static_cast<PairValue*>(current)->getCar(), nested.shadowed);
+    }
+    resolveEach(body, nested);
+}
+
+static bool isMacro(const std::string& name, const SlotScope& scope) {
+    if (std::ranges::find(*scope.layout, name) != scope.layout->end() ||
+        std::ranges::find(scope.shadowed, name) != scope.shadowed.end()) {
+        return false;
+    }
+    const auto value = scope.env->lookupBinding(name);
+    return value != nullptr && value->getType() == ValueType::MACRO;
+}
+
+/**
+ * Forms binding variables in an environment of their own, quoted data and macro uses are not
+ * entered, the references in them are looked up by name
+ */
+static void resolveSlots(const ValuePtr& expr, const SlotScope& scope) {
+    if (expr->getType() == ValueType::SYMBOL) {
+        const auto symbol = static_cast<SymbolValue*>(expr);
+        const auto& name = symbol->getValue();
+        if (std::ranges::find(scope.shadowed, name) != scope.shadowed.end()) {
+            return;
+        }
+        if (const auto it = std::ranges::find(*scope.layout, name); it != scope.layout->end()) {
+            const auto index = static_cast<size_t>(it - scope.layout->begin());
+            symbol->setAddress({scope.layout, scope.depth, index});
+        }
+        return;
+    }
+    if (expr->getType() != ValueType::PAIR) {
+        return;
+    }
+    const auto pair = static_cast<PairValue*>(expr);
+    const auto operands = pair->getCdr();
+    if (pair->getCar()->getType() != ValueType::SYMBOL) {
+        resolveEach(expr, scope);
+        return;
+    }
+    const auto head = static_cast<SymbolValue*>(pair->getCar());
+    const auto form = head->getForm();
+    if (form == nullptr) {
+        if (!isMacro(head->getValue(), scope)) {
+            resolveEach(expr, scope);
+        }
+    } else if (form == &ifForm || form == &andForm || form == &orForm || form == &beginForm ||
+               form == &setForm || form == &evalForm) {
+        resolveEach(operands, scope);
+    } else if (form == &condForm) {
+        for (auto clause = operands; clause->getType() == ValueType::PAIR;
+             clause = static_cast<PairValue*>(clause)->getCdr()) {
+            resolveEach(static_cast<PairValue*>(clause)->getCar(), scope);
+        }
+    } else if (form == &lambdaForm && operands->getType() == ValueType::PAIR) {
+        const auto lambda = static_cast<PairValue*>(operands);
+        resolveNested(lambda->getCar(), lambda->getCdr(), scope);
+    } else if (form == &defineForm && operands->getType() == ValueType::PAIR) {
+        const auto definition = static_cast<PairValue*>(operands);
+        if (definition->getCar()->getType() == ValueType::PAIR) {
+            const auto formals = static_cast<PairValue*>(definition->getCar())->getCdr();
+            resolveNested(formals, definition->getCdr(), scope);
+        } else {
+            resolveEach(definition->getCdr(), scope);
+        }
+    }
+}
+
+void LambdaValue::resolveSlots(const std::shared_ptr<const FrameLayout>& layout,
+                               const std::vector<ValuePtr>& body, const EvalEnv* env) {
+    const SlotScope scope{layout, 0, {}, env};
+    for (const auto& expr : body) {
+        ::resolveSlots(expr, scope);
+    }
+}
+
+std::shared_ptr<const FrameLayout> LambdaValue::frameLayout(std::vector<std::string> params,
+                                                            const std::vector<ValuePtr>& body) {
+    for (const auto& expr : body) {
+        collectDefinitions(expr, params);
+    }
+    return std::make_shared<const FrameLayout>(std::move(params));
+}
+
 std::string LambdaValue::toString() const {
     return "#<proc>";
 }
 
-ValuePtr LambdaValue::apply(const std::vector<ValuePtr>& args) const {
-    if (args.size() != params.size()) {
+EvalEnv* LambdaValue::bind(const std::vector<ValuePtr>& args) const {
+    // Create a new environment
+    const auto newEnv = ValuePool::instance()->makeEnv(env);
+    newEnv->owner = this;
+    newEnv->reserveSlots(layout);
+    rebind(newEnv, args);
+    return newEnv;
+}
+
+void LambdaValue::checkArity(const size_t count, const std::optional<Location>& location) const {
+    if (rest != RestParam::NONE && count < paramCount) {
         throw ValueError(
-            std::format("Expected {} arguments, but got {}", params.size(), args.size()),
-            Location::fromRange(args));
+            std::format("Expected at least {} arguments, but got {}", paramCount, count),
+            location);
     }
-    // Create a new environment
+    if (rest == RestParam::NONE && count != paramCount) {
+        throw ValueError(std::format("Expected {} arguments, but got {}", paramCount, count),
+                         location);
+    }
+}
+
+void LambdaValue::rebind(EvalEnv* frame, const std::vector<ValuePtr>& args) const {
+    checkArity(args.size(), Location::fromRange(args));
+    for (size_t i = 0; i < paramCount; i++) {
+        frame->setSlot(i, args[i]);
+    }
+    // the definitions of a previous call in the frame are not seen by this one
+    const auto defined = paramCount + (rest == RestParam::NONE ? 0 : 1);
+    std::fill(frame->slots.begin() + defined, frame->slots.end(), nullptr);
+    if (!frame->symbolTable.empty()) {
+        frame->symbolTable.clear();
+    }
+    if (rest == RestParam::NONE) {
+        return;
+    }
+    ListBuilder restList;
+    if (getRestParam() == RestParam::USED) {
+        for (const auto& arg : std::views::drop(args, paramCount)) {
+            restList.push(arg);
+        }
+    }
+    frame->setSlot(paramCount, restList.build());
+}
+
+ValuePtr LambdaValue::applyList(ValuePtr args) const {
     const auto newEnv = ValuePool::instance()->makeEnv(env);
-    for (size_t i = 0; i < params.size(); i++) {
-        newEnv->addVariable(params[i], args[i]);
+    newEnv->owner = this;
+    newEnv->reserveSlots(layout);
+    size_t count = 0;
+    for (; count < paramCount && args->getType() == ValueType::PAIR; count++) {
+        const auto pair = static_cast<PairValue*>(args);
+        newEnv->setSlot(count, pair->getCar());
+        args = pair->getCdr();
     }
+    if (args->getType() != ValueType::NIL && args->getType() != ValueType::PAIR) {
+        throw ValueError("Expected a list of arguments", args->getLocation());
+    }
+    if (rest == RestParam::NONE) {
+        for (; args->getType() == ValueType::PAIR; args = static_cast<PairValue*>(args)->getCdr()) {
+            count++;
+        }
+        checkArity(count, std::nullopt);
+    } else {
+        checkArity(count, std::nullopt);
+        newEnv->setSlot(paramCount, args);
+    }
+    return run(newEnv);
+}
+
+const std::vector<ValuePtr>& LambdaValue::getBody() const {
+    return body;
+}
+
+ValuePtr LambdaValue::apply(const std::vector<ValuePtr>& args) const {
+    return run(bind(args));
+}
+
+ValuePtr LambdaValue::run(EvalEnv* frame) const {
     ValuePtr result = LISP_NIL;
     for (const auto& expr : body) {
-        result = newEnv->eval(expr);
+        result = frame->eval(expr);
     }
     return result;
 }
@@ -248,7 +582,66 @@ bool LambdaValue::equals(const ValuePtr& other) const {
         return false;
     }
     const auto otherLambda = dynamic_cast<LambdaValue*>(other);
-    return params == otherLambda->params && body == otherLambda->body;
+    return paramCount == otherLambda->paramCount && rest == otherLambda->rest &&
+           *layout == *otherLambda->layout && body == otherLambda->body;
+}
+
+std::vector<ValuePtr> LambdaValue::children() const {
+    return body;
+}
+
+MultipleValues MultipleValues::marker{};
+
+std::vector<ValuePtr> MultipleValues::returnArea{};
+
+ValuePtr MultipleValues::of(const std::vector<ValuePtr>& values) {
+    if (values.size() == 1) {
+        return values[0];
+    }
+    if (std::ranges::find(values, &marker) != values.end()) {
+        throw ValueError("Multiple values cannot be used as a single value", std::nullopt);
+    }
+    returnArea = values;
+    return &marker;
+}
+
+std::vector<ValuePtr> MultipleValues::unpack(ValuePtr value) {
+    if (value == &marker) {
+        return returnArea;
+    }
+    return {value};
+}
+
+ValuePtr MultipleValues::single(ValuePtr value) {
+    if (value == &marker) {
+        throw ValueError(
+            std::format("Expected a single value, but got {} values", returnArea.size()),
+            std::nullopt);
+    }
+    return value;
+}
+
+const MultipleValues* MultipleValues::getMarker() {
+    return &marker;
+}
+
+std::vector<ValuePtr> MultipleValues::children() const {
+    return returnArea;
+}
+
+std::string MultipleValues::toString() const {
+    std::stringstream ss;
+    for (const auto& value : returnArea) {
+        if (&value != &returnArea.front()) {
+            ss << ' ';
+        }
+        ss << value->toString();
+    }
+    return ss.str();
+}
+
+bool MultipleValues::equals(const ValuePtr& other) const {
+    return this == other;
 }
 
 std::string NilValue::toString() const {
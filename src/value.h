@@ -1,12 +1,14 @@
 #ifndef VALUE_H
 #define VALUE_H
 
+#include <memory>
 #include <optional>
 #include <set>
 #include <string>
 #include <vector>
 
 #include "location.h"
+#include "number.h"
 
 class Value;
 
@@ -14,6 +16,9 @@ using ValuePtr = Value*;
 
 class EvalEnv;
 class SymbolValue;
+struct FormResult;
+
+using SpecialFormType = FormResult(const std::vector<ValuePtr>&, EvalEnv*);
 
 enum class ValueType {
     BOOLEAN,
@@ -24,6 +29,10 @@ enum class ValueType {
     PAIR,
     BUILTIN,
     LAMBDA,
+    MACRO,
+    VALUES,
+    RECORD_TYPE,
+    RECORD,
 };
 
 class Value {
@@ -45,7 +54,10 @@ public:
     virtual bool equals(const ValuePtr& other) const = 0;
     const std::optional<Location>& getLocation() const;
 
-    std::vector<ValuePtr> children();
+    /**
+     * Values directly referenced by this value, used by the garbage collector
+     */
+    virtual std::vector<ValuePtr> children() const;
 };
 
 using BuiltinFuncType = ValuePtr(const std::vector<ValuePtr>&);
@@ -63,14 +75,15 @@ public:
 };
 
 class NumericValue : public Value {
-    double value;
+    Number value;
 
 public:
-    explicit NumericValue(const double value,
-                          const std::optional<Location>& location = std::nullopt)
-        : Value(ValueType::NUMBER, location), value{value} {}
+    explicit NumericValue(Number value, const std::optional<Location>& location = std::nullopt)
+        : Value(ValueType::NUMBER, location), value(std::move(value)) {}
 
     std::string toString() const override;
+    const Number& getNumber() const;
+    /// The value as a double, which is inexact for large integers
     double getValue() const;
     bool equals(const ValuePtr& other) const override;
 };
@@ -97,19 +110,59 @@ public:
     bool equals(const ValuePtr& other) const override;
 };
 
+/// Names of the variables of a call frame, the parameters followed by the internal definitions
+using FrameLayout = std::vector<std::string>;
+
+/// Where the variable a symbol refers to is found, relative to the frame the symbol is evaluated in
+struct SlotAddress {
+    std::shared_ptr<const FrameLayout> layout;  // layout of the frame defining the variable
+    size_t depth = 0;                           // number of parents up to that frame
+    size_t index = 0;
+};
+
 class SymbolValue : public Value {
     std::string value;
+    SpecialFormType* form;
+    mutable SlotAddress address;
 
 public:
     explicit SymbolValue(const std::string& value,
-                         const std::optional<Location>& location = std::nullopt)
-        : Value(ValueType::SYMBOL, location), value{value} {}
+                         const std::optional<Location>& location = std::nullopt);
 
     std::string toString() const override;
-    std::string getValue() const;
+    const std::string& getValue() const;
+
+    /**
+     * The special form named by this symbol. It is resolved once when the symbol is created, so
+     * the evaluator does not have to look keywords up by name for every evaluated list.
+     * @return the special form, or nullptr if the symbol is not a keyword
+     */
+    SpecialFormType* getForm() const;
+
+    /**
+     * The slot the symbol refers to, resolved when the procedure containing it is analyzed. Its
+     * layout is nullptr if the symbol is looked up by name.
+     */
+    const SlotAddress& getAddress() const;
+    void setAddress(SlotAddress address) const;
     bool equals(const ValuePtr& other) const override;
 };
 
+/**
+ * Data derived from a list when it is evaluated as code, e.g. a macro expansion. It is cached for
+ * the list, so it is computed once per call site rather than once per evaluation. The cache is
+ * kept in a side table of the pool, so that pairs of ordinary data do not pay for it.
+ */
+class CodeCache {
+public:
+    virtual ~CodeCache() = default;
+
+    /**
+     * Values referenced by the cached data, used by the garbage collector
+     */
+    virtual std::vector<ValuePtr> children() const;
+};
+
 class PairValue : public Value {
     ValuePtr car;
     ValuePtr cdr;
@@ -130,7 +183,13 @@ public:
 
     ValuePtr getCar() const;
     ValuePtr getCdr() const;
+    void setCar(ValuePtr value);
+    void setCdr(ValuePtr value);
+    /// The data cached for the pair as code, or nullptr if there is none
+    CodeCache* getCache() const;
+    void setCache(std::shared_ptr<CodeCache> newCache);
     bool equals(const ValuePtr& other) const override;
+    std::vector<ValuePtr> children() const override;
 };
 
 class BuiltinProcValue : public Value {
@@ -142,27 +201,147 @@ public:
         : Value(ValueType::BUILTIN, location), func(func) {}
 
     std::string toString() const override;
-    ValuePtr apply(const std::vector<ValuePtr>& args) const;
+    virtual ValuePtr apply(const std::vector<ValuePtr>& args) const;
+    BuiltinFuncType* getFunc() const;
     bool equals(const ValuePtr& other) const override;
 };
 
+/// Whether a procedure has a rest parameter, and whether its body refers to it at all
+enum class RestParam {
+    NONE,
+    UNUSED,
+    USED,
+};
+
 class LambdaValue : public Value {
 protected:
-    std::vector<std::string> params;
+    std::shared_ptr<const FrameLayout> layout;
+    size_t paramCount;  // without the rest parameter, which follows the others in the layout
+    mutable RestParam rest;
+    mutable size_t analyzed;  // value of EvalEnv::redefinitions when `rest` was determined
     std::vector<ValuePtr> body;
     mutable EvalEnv* env;
 
+    void checkArity(size_t count, const std::optional<Location>& location) const;
+    ValuePtr run(EvalEnv* frame) const;
+
 public:
     LambdaValue(std::vector<std::string> params, std::vector<ValuePtr> body, EvalEnv* env,
                 const std::optional<Location>& location = std::nullopt);
+    LambdaValue(std::shared_ptr<const FrameLayout> layout, size_t paramCount, RestParam rest,
+                std::vector<ValuePtr> body, EvalEnv* env,
+                const std::optional<Location>& location = std::nullopt);
+
+    /**
+     * Lay out the call frame of a procedure. Definitions at the top level of the body, also inside
+     * `begin`, get a slot of their own, so defining local helpers does not insert into a hash table
+     * on every call.
+     */
+    static std::shared_ptr<const FrameLayout> frameLayout(std::vector<std::string> params,
+                                                          const std::vector<ValuePtr>& body);
+
+    /**
+     * Resolve the references to variables of the frame in `body`, and in the procedures nested in
+     * it, to slots, so they are looked up without comparing names. `env` is the environment the
+     * procedure is created in.
+     */
+    static void resolveSlots(const std::shared_ptr<const FrameLayout>& layout,
+                             const std::vector<ValuePtr>& body, const EvalEnv* env);
 
     std::string toString() const override;
     virtual ValuePtr apply(const std::vector<ValuePtr>& args) const;
     bool equals(const ValuePtr& other) const override;
+    std::vector<ValuePtr> children() const override;
+
+    /**
+     * Create the environment of a call and bind the arguments to the parameters
+     * @param args arguments of the call
+     * @return environment to evaluate the body in
+     */
+    EvalEnv* bind(const std::vector<ValuePtr>& args) const;
+
+    /**
+     * Mark the environment of the procedure as captured, as it may be used after the frames it
+     * refers to have been left. Closures do so when they are created, a named `let` loop only when
+     * it is used as a value instead of being called.
+     */
+    void escape() const;
+
+    /**
+     * Bind the arguments of another call in a frame created by `bind`, instead of creating a new
+     * environment. Only valid if nothing else refers to the frame anymore. The definitions made
+     * by the previous call are dropped.
+     */
+    void rebind(EvalEnv* frame, const std::vector<ValuePtr>& args) const;
+
+    /**
+     * Call the procedure with arguments given as a list. A rest parameter is bound to the tail
+     * of the list itself, it is not copied.
+     */
+    ValuePtr applyList(ValuePtr args) const;
+    const std::vector<ValuePtr>& getBody() const;
+
+    /**
+     * Whether a rest parameter named `name` is needed by `body`, whose frame is laid out as
+     * `layout` and whose enclosing environment is `env`. If not, the rest list of a call is never
+     * built. Calls to macros count as uses, since a macro may expand to the name.
+     */
+    static RestParam restParam(const std::string& name, const FrameLayout& layout,
+                               const std::vector<ValuePtr>& body, const EvalEnv* env);
+
+    /**
+     * Whether the procedure has a rest parameter and needs it, analyzing the body again if
+     * global macros have been defined since
+     */
+    RestParam getRestParam() const;
 
     friend class ValuePool;
 };
 
+/**
+ * Several values returned at once by `values`. They are kept in a static return area instead of a
+ * list, so returning them allocates nothing. The result of `values` is a marker standing for the
+ * contents of the area, valid until the next multiple values are returned.
+ *
+ * Only `call-with-values` and `let-values` take the values apart. Anywhere a result is kept as a
+ * single value (bound to a variable, passed as an argument, stored in a pair) the marker is an
+ * error, so it never outlives the contents of the area.
+ */
+class MultipleValues : public Value {
+    static MultipleValues marker;
+    static std::vector<ValuePtr> returnArea;
+
+    MultipleValues() : Value(ValueType::VALUES, std::nullopt) {}
+
+public:
+    /**
+     * Return several values
+     * @return the only value if there is exactly one, the marker otherwise
+     */
+    static ValuePtr of(const std::vector<ValuePtr>& values);
+
+    /**
+     * The values a result stands for, i.e. the contents of the return area for the marker and the
+     * value itself for anything else
+     */
+    static std::vector<ValuePtr> unpack(ValuePtr value);
+
+    /**
+     * A result that is kept as a single value
+     * @throw ValueError if it is the marker
+     */
+    static ValuePtr single(ValuePtr value);
+
+    /**
+     * The marker and the values it currently stands for, used by the garbage collector
+     */
+    static const MultipleValues* getMarker();
+    std::vector<ValuePtr> children() const override;
+
+    std::string toString() const override;
+    bool equals(const ValuePtr& other) const override;
+};
+
 extern const std::set<ValueType> SELF_EVAL_VALUES;
 
 extern const std::set<ValueType> ATOMIC_VALUES;
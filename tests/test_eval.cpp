@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 #include <pool.h>
 
+#include <format>
+
+#include "error.h"
 #include "eval_env.h"
 #include "parser.h"
 #include "rjsj_test.hpp"
@@ -71,4 +74,459 @@ TEST(list_test_eval, Sicp) {
     ValuePool::instance()->root()->reset();
     RUN_TEST(rjsj_mini_lisp_test_Sicp, eval);
     ValuePool::dispose();
-}
\ No newline at end of file
+}
+
+const rjsj_mini_lisp_test::Cases extra_test_Numeric{
+    "Numeric",
+    {
+        {"(+ 1 (* 2 3) (- 10 (/ 8 2)))", "13"},
+        {"(define x 4)", std::nullopt},
+        {"(< (* x x) (+ x 13))", "#t"},
+        {"(- (+ x 1))", "-5"},
+        {"(+ (abs -1) (* 2 (- x)))", "-7"},
+        {"(define (* a b) (list a b))", std::nullopt},
+        {"(+ 1 (car (* 2 3)))", "3"},
+    }};
+
+TEST(list_test_eval, Numeric) {
+    ValuePool::instance()->root()->reset();
+    RUN_TEST(extra_test_Numeric, eval);
+    EXPECT_THROW(eval("(+ 1 (- 2 \"a\"))"), ValueError);
+    EXPECT_THROW(eval("(- 1 2 3)"), ValueError);
+    ValuePool::dispose();
+}
+
+const rjsj_mini_lisp_test::Cases extra_test_Pipeline{
+    "Pipeline",
+    {
+        {"(define xs '(1 2 3 4 5 6))", std::nullopt},
+        {"(reduce + (map (lambda (x) (* x x)) (filter even? xs)))", "56"},
+        {"(map - (filter odd? (map (lambda (x) (+ x 1)) xs)))", "(-3 -5 -7)"},
+        {"(filter (lambda (x) (> x 10)) (map abs xs))", "()"},
+        {"(map abs '())", "()"},
+        {"(reduce cons (map abs xs))", "(1 2 3 4 5 . 6)"},
+    }};
+
+TEST(list_test_eval, Pipeline) {
+    ValuePool::instance()->root()->reset();
+    RUN_TEST(extra_test_Pipeline, eval);
+    EXPECT_THROW(eval("(reduce + (filter odd? '(2 4)))"), TypeError);
+    EXPECT_THROW(eval("(map abs (filter odd? '(1 . 2)))"), ValueError);
+    ValuePool::dispose();
+}
+
+const rjsj_mini_lisp_test::Cases extra_test_TailCall{
+    "TailCall",
+    {
+        {"(define (count n acc) (if (= n 0) acc (count (- n 1) (+ acc 1))))", std::nullopt},
+        {"(count 20000 0)", "20000"},
+        {"(define (range a b) (if (>= a b) '() (cons a (range (+ a 1) b))))", std::nullopt},
+        {"(range 0 5)", "(0 1 2 3 4)"},
+        {"(define (keep-even lst) (cond ((null? lst) '()) ((even? (car lst)) (cons (car lst) "
+         "(keep-even (cdr lst)))) (else (keep-even (cdr lst)))))",
+         std::nullopt},
+        {"(length (keep-even (range 0 20000)))", "10000"},
+        {"(equal? (range 0 20000) (range 0 20000))", "#t"},
+    }};
+
+TEST(list_test_eval, TailCall) {
+    ValuePool::instance()->root()->reset();
+    RUN_TEST(extra_test_TailCall, eval);
+    // the tail of `and` is evaluated in place, once
+    testing::internal::CaptureStdout();
+    EXPECT_EQ(eval("(and 1 (begin (print 1) 2))"), "2");
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "1 \n");
+    ValuePool::dispose();
+}
+
+TEST(list_test_eval, RecursionLimit) {
+    ValuePool::instance()->root()->reset();
+    const auto maxDepth = EvalEnv::maxDepth;
+    EvalEnv::maxDepth = 500;
+    eval("(define (f n) (if (= n 0) 0 (+ 1 (f (- n 1)))))");
+    EXPECT_EQ(eval("(f 100)"), "100");
+    EXPECT_THROW(eval("(f 1000)"), RecursionError);
+    // the depth is unwound after the error
+    EXPECT_EQ(eval("(f 100)"), "100");
+    EvalEnv::maxDepth = maxDepth;
+    // at the default depth the stack of the test runner may run out first, which is an error too
+    EXPECT_THROW(eval(std::format("(f {})", 10 * EvalEnv::maxDepth)), RecursionError);
+    EXPECT_EQ(eval("(f 100)"), "100");
+    ValuePool::dispose();
+}
+
+const rjsj_mini_lisp_test::Cases extra_test_Macro{
+    "Macro",
+    {
+        {"(defmacro (swap-args f a b) (list f b a))", std::nullopt},
+        {"(swap-args - 1 10)", "9"},
+        {"(defmacro my-if (c a b) (list 'cond (list c a) (list 'else b)))", std::nullopt},
+        {"(define (fact n) (my-if (= n 0) 1 (* n (fact (- n 1)))))", std::nullopt},
+        {"(fact 5)", "120"},
+        {"(define-syntax my-or (syntax-rules () ((_) #f) ((_ e) e) ((_ e r ...) (let ((t e)) "
+         "(if t t (my-or r ...))))))",
+         std::nullopt},
+        {"(my-or #f #f 3)", "3"},
+        {"(my-or)", "#f"},
+        {"(define-syntax my-let* (syntax-rules () ((_ () body ...) (begin body ...)) ((_ ((x v) "
+         "rest ...) body ...) (let ((x v)) (my-let* (rest ...) body ...)))))",
+         std::nullopt},
+        {"(my-let* ((a 1) (b (+ a 1))) (list a b))", "(1 2)"},
+        {"(define-syntax for (syntax-rules (in) ((_ x in xs body) (map (lambda (x) body) xs))))",
+         std::nullopt},
+        {"(for y in '(1 2 3) (* y y))", "(1 4 9)"},
+        {"(define-syntax m (syntax-rules () ((_) 1)))", std::nullopt},
+        {"(define (f) (m))", std::nullopt},
+        {"(f)", "1"},
+        {"(define-syntax m (syntax-rules () ((_) 2)))", std::nullopt},
+        {"(f)", "2"},
+        {"(eq? (gensym) (gensym))", "#f"},
+    }};
+
+TEST(list_test_eval, Macro) {
+    ValuePool::instance()->root()->reset();
+    RUN_TEST(extra_test_Macro, eval);
+    EXPECT_THROW(eval("(for y of '(1) y)"), ValueError);
+    ValuePool::dispose();
+}
+
+const rjsj_mini_lisp_test::Cases extra_test_EvalCache{
+    "EvalCache",
+    {
+        {"(define-syntax twice (syntax-rules () ((_ e) (* 2 e))))", std::nullopt},
+        {"(define (run x) (eval (list 'twice x)))", std::nullopt},
+        {"(run 3)", "6"},
+        {"(run 3)", "6"},
+        {"(run 4)", "8"},
+        {"(define-syntax twice (syntax-rules () ((_ e) (* 3 e))))", std::nullopt},
+        {"(run 3)", "9"},
+        {"(define f (lambda () 1))", std::nullopt},
+        {"(define g (lambda () 2))", std::nullopt},
+        {"(eval (list f))", "1"},
+        {"(eval (list g))", "2"},
+        {"(eq? (eval (list 'quote (list 1 2))) (eval (list 'quote (list 1 2))))", "#f"},
+        {"(let ((l (list 1))) (eq? l (eval (list 'quote l))))", "#t"},
+        {"(define a (eval (list 'quote (list 1 2))))", std::nullopt},
+        {"(define b (eval (list 'quote (list 1 2))))", std::nullopt},
+        {"(set-car! a 9)", "()"},
+        {"(list a b)", "((9 2) (1 2))"},
+        {"(let ((s \"text\")) (eq? s (eval (list 'begin s))))", "#t"},
+    }};
+
+TEST(list_test_eval, EvalCache) {
+    ValuePool::instance()->root()->reset();
+    RUN_TEST(extra_test_EvalCache, eval);
+    ValuePool::dispose();
+}
+
+const rjsj_mini_lisp_test::Cases extra_test_Loop{
+    "Loop",
+    {
+        {"(let loop ((i 0) (acc 0)) (if (= i 100000) acc (loop (+ i 1) (+ acc i))))", "4999950000"},
+        {"(let fib ((n 10)) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))", "55"},
+        {"(define (f n) (begin (if (> n 0) (f (- n 1)) 0) n))", std::nullopt},
+        {"(f 3)", "3"},
+        {"(define fs (let loop ((i 0) (acc '())) (if (= i 3) acc (loop (+ i 1) (cons (lambda () "
+         "i) acc)))))",
+         std::nullopt},
+        {"(map (lambda (f) (f)) fs)", "(2 1 0)"},
+        {"(do ((i 0 (+ i 1)) (acc '() (cons i acc))) ((= i 5) acc))", "(4 3 2 1 0)"},
+        {"(do ((vec '(1 2 3)) (i 0 (+ i 1))) ((= i 3) (length vec)))", "3"},
+        {"(define gs (do ((i 0 (+ i 1)) (acc '() (cons (lambda () i) acc))) ((= i 3) acc)))",
+         std::nullopt},
+        {"(map (lambda (g) (g)) gs)", "(2 1 0)"},
+        {"(let () 1)", "1"},
+        {"(define (outer n) (let loop ((i 0)) (if (< i 2) (loop (+ i 1)) i)) (if (= n 0) 'done "
+         "(outer (- n 1))))",
+         std::nullopt},
+        {"(outer 20000)", "done"},
+        {"(define (escape n saved) (if (= n 0) (saved 1) (escape (- n 1) (if (null? saved) (let "
+         "loop ((k 0)) (if (= k 0) loop n)) saved))))",
+         std::nullopt},
+        {"(escape 3 '())", "3"},
+        {"(define (inner n saved) (if (= n 0) (saved) (inner (- n 1) (if (null? saved) (let loop "
+         "((k 0)) (lambda () n)) saved))))",
+         std::nullopt},
+        {"(inner 3 '())", "3"},
+    }};
+
+TEST(list_test_eval, Loop) {
+    ValuePool::instance()->root()->reset();
+    RUN_TEST(extra_test_Loop, eval);
+    EXPECT_THROW(eval("(do ((i 0)) i)"), TypeError);
+    ValuePool::dispose();
+}
+
+const rjsj_mini_lisp_test::Cases extra_test_Letrec{
+    "Letrec",
+    {
+        {"(letrec ((ev? (lambda (n) (if (= n 0) #t (od? (- n 1))))) (od? (lambda (n) (if (= n 0) "
+         "#f (ev? (- n 1)))))) (ev? 100))",
+         "#t"},
+        {"(letrec* ((a 1) (b (+ a 1))) (list a b))", "(1 2)"},
+        {"(letrec () 1)", "1"},
+        {"(define (f x) (define (sq y) (* y y)) (begin (define z 3)) (+ (sq x) z))", std::nullopt},
+        {"(f 2)", "7"},
+        {"(f 3)", "12"},
+        {"(define z 100)", std::nullopt},
+        {"(define (g) (define y z) (define z 1) y)", std::nullopt},
+        {"(g)", "100"},
+        {"(define (h n) (if (= n 0) 'done (begin (define m n) (h (- m 1)))))", std::nullopt},
+        {"(h 10)", "done"},
+        {"(define w 'outer)", std::nullopt},
+        {"(define (p n) (define r w) (define w n) (if (= n 0) r (p (- n 1))))", std::nullopt},
+        {"(p 3)", "outer"},
+        {"(define (adder n) (lambda (x) (if (> x 0) (+ x n) ((lambda (n) n) x))))", std::nullopt},
+        {"((adder 2) 3)", "5"},
+        {"((adder 2) -3)", "-3"},
+        {"(define (shadow x) (let ((x 10)) x))", std::nullopt},
+        {"(shadow 1)", "10"},
+        {"(define (hidden x) ((lambda () (eval '(define x 7)) x)))", std::nullopt},
+        {"(hidden 1)", "7"},
+        {"(hidden 2)", "7"},
+    }};
+
+TEST(list_test_eval, Letrec) {
+    ValuePool::instance()->root()->reset();
+    RUN_TEST(extra_test_Letrec, eval);
+    ValuePool::dispose();
+}
+
+const rjsj_mini_lisp_test::Cases extra_test_Assignment{
+    "Assignment",
+    {
+        {"(define count 0)", std::nullopt},
+        {"(define (inc!) (set! count (+ count 1)) count)", std::nullopt},
+        {"(inc!)", "1"},
+        {"(inc!)", "2"},
+        {"(define (make-counter) (let ((n 0)) (lambda () (set! n (+ n 1)) n)))", std::nullopt},
+        {"(define c1 (make-counter))", std::nullopt},
+        {"(define c2 (make-counter))", std::nullopt},
+        {"(begin (c1) (c1) (c2) (list (c1) (c2)))", "(3 2)"},
+        {"(let loop ((i 0) (sum 0)) (if (= i 5) sum (begin (set! sum (+ sum i)) (loop (+ i 1) "
+         "sum))))",
+         "10"},
+        {"(define xs (list 1 2 3))", std::nullopt},
+        {"(set-car! (cdr xs) 20)", std::nullopt},
+        {"(set-cdr! (cdr xs) '(30))", std::nullopt},
+        {"xs", "(1 20 30)"},
+        {"(define gs (do ((i 0 (+ i 1)) (acc '() (cons (lambda () (set! i (* i 10)) i) acc))) ((= "
+         "i 3) acc)))",
+         std::nullopt},
+        {"(map (lambda (g) (g)) gs)", "(20 10 0)"},
+    }};
+
+TEST(list_test_eval, Assignment) {
+    ValuePool::instance()->root()->reset();
+    RUN_TEST(extra_test_Assignment, eval);
+    EXPECT_THROW(eval("(set! undefined-variable 1)"), ValueError);
+    EXPECT_THROW(eval("(set-car! '() 1)"), TypeError);
+    ValuePool::dispose();
+}
+
+const rjsj_mini_lisp_test::Cases extra_test_Variadic{
+    "Variadic",
+    {
+        {"((lambda args args) 1 2 3)", "(1 2 3)"},
+        {"((lambda (a . rest) (list a rest)) 1 2 3)", "(1 (2 3))"},
+        {"((lambda (a . rest) rest) 1)", "()"},
+        {"(define (count . xs) (length xs))", std::nullopt},
+        {"(count 1 2 3 4)", "4"},
+        {"(define (ignore a . rest) a)", std::nullopt},
+        {"(ignore 1 2 3)", "1"},
+        {"(define (tail-of . xs) (eval 'xs))", std::nullopt},
+        {"(tail-of 1 2)", "(1 2)"},
+        {"(define xs (list 1 2 3))", std::nullopt},
+        {"(eq? (apply (lambda (a . rest) rest) xs) (cdr xs))", "#t"},
+        {"(apply + '())", "0"},
+        {"(apply (lambda (a b) (+ a b)) '(1 2))", "3"},
+        {"(define (sum . xs) (if (null? xs) 0 (+ (car xs) (apply sum (cdr xs)))))", std::nullopt},
+        {"(sum 1 2 3 4)", "10"},
+        {"(defmacro (my-list . items) (cons 'list items))", std::nullopt},
+        {"(my-list 1 (+ 1 1))", "(1 2)"},
+        {"(defmacro (all-args) 'args)", std::nullopt},
+        {"((lambda args (all-args)) 1 2 3)", "(1 2 3)"},
+        {"(define (first-arg . xs) (begin (car (all-xs))))", std::nullopt},
+        {"(defmacro (all-xs) 'xs)", std::nullopt},
+        {"(first-arg 4 5)", "4"},
+    }};
+
+TEST(list_test_eval, Variadic) {
+    ValuePool::instance()->root()->reset();
+    RUN_TEST(extra_test_Variadic, eval);
+    EXPECT_THROW(eval("((lambda (a b . c) a) 1)"), ValueError);
+    EXPECT_THROW(eval("(apply (lambda (a b) a) '(1 2 3))"), ValueError);
+    // the rest list is only built when the body may refer to it
+    const auto restOf = [](const std::string& code) {
+        Parser parser(Tokenizer::tokenize(code, "<test>", 0));
+        const auto lambda = ValuePool::instance()->root()->eval(parser.parse());
+        return static_cast<LambdaValue*>(lambda)->getRestParam();
+    };
+    EXPECT_EQ(restOf("(lambda (a . rest) (+ a 1))"), RestParam::UNUSED);
+    EXPECT_EQ(restOf("(lambda (a . rest) (display (car rest)))"), RestParam::USED);
+    EXPECT_EQ(restOf("(lambda args (all-args))"), RestParam::USED);
+    ValuePool::dispose();
+}
+
+const rjsj_mini_lisp_test::Cases extra_test_Values{
+    "Values",
+    {
+        {"(define (div-mod a b) (values (quotient a b) (remainder a b)))", std::nullopt},
+        {"(call-with-values (lambda () (div-mod 17 5)) list)", "(3 2)"},
+        {"(call-with-values (lambda () 1) list)", "(1)"},
+        {"(call-with-values (lambda () (values)) list)", "()"},
+        {"(let-values (((q r) (div-mod 17 5)) ((x) 9)) (+ q r x))", "14"},
+        {"(let-values (((a . rest) (values 1 2 3)) (all (values 4 5))) (list a rest all))",
+         "(1 (2 3) (4 5))"},
+        {"(values 1 2)", "1 2"},
+        {"(values 7)", "7"},
+        {"(map (lambda (x) (call-with-values (lambda () (values x 0)) list)) '(1 2))",
+         "((1 0) (2 0))"},
+    }};
+
+TEST(list_test_eval, Values) {
+    ValuePool::instance()->root()->reset();
+    RUN_TEST(extra_test_Values, eval);
+    EXPECT_THROW(eval("(let-values (((a b) (values 1 2 3))) a)"), ValueError);
+    EXPECT_THROW(eval("(values (values 1 2) 3)"), ValueError);
+    // multiple values cannot be kept as a single value
+    EXPECT_THROW(eval("(define x (values 1 2))"), ValueError);
+    EXPECT_THROW(eval("(list (values 5 6) (values 7 8))"), ValueError);
+    EXPECT_THROW(eval("(let ((a (values 1 2))) a)"), ValueError);
+    EXPECT_THROW(eval("(cons 1 (values 2 3))"), ValueError);
+    EXPECT_THROW(eval("(map (lambda (x) (values x 0)) '(1 2))"), ValueError);
+    EXPECT_THROW(eval("(reduce (lambda (x acc) (values x acc)) '(1 2 3))"), ValueError);
+    ValuePool::dispose();
+}
+
+const rjsj_mini_lisp_test::Cases extra_test_Record{
+    "Record",
+    {
+        {"(define-record-type <point> (make-point x y) point? (x point-x set-point-x!) "
+         "(y point-y))",
+         std::nullopt},
+        {"(define p (make-point 1 2))", std::nullopt},
+        {"(list (point-x p) (point-y p))", "(1 2)"},
+        {"(list (point? p) (point? '(1 2)) (point? 1))", "(#t #f #f)"},
+        {"(set-point-x! p 10)", "()"},
+        {"(point-x p)", "10"},
+        {"p", "#<point x: 10 y: 2>"},
+        {"<point>", "#<record-type point>"},
+        {"(define-record-type node (make-node value) node? (value node-value) (next node-next "
+         "set-node-next!))",
+         std::nullopt},
+        {"(define n (make-node 1))", std::nullopt},
+        {"(node-next n)", "()"},
+        {"(set-node-next! n p)", "()"},
+        {"(point-y (node-next n))", "2"},
+        {"(list (node? p) (equal? p p) (equal? (make-point 1 2) (make-point 1 2)))", "(#f #t #f)"},
+        {"(map point-x (list (make-point 1 0) (make-point 2 0)))", "(1 2)"},
+    }};
+
+TEST(list_test_eval, Record) {
+    ValuePool::instance()->root()->reset();
+    RUN_TEST(extra_test_Record, eval);
+    EXPECT_THROW(eval("(point-x n)"), TypeError);
+    EXPECT_THROW(eval("(make-point 1)"), ValueError);
+    EXPECT_THROW(eval("(define-record-type q (make-q z) q? (x q-x))"), ValueError);
+    ValuePool::dispose();
+}
+
+const rjsj_mini_lisp_test::Cases extra_test_Case{
+    "Case",
+    {
+        {"(define (kind x) (case x ((1 2 3) 'small) ((10 20) 'big) ((a b) 'sym) ((#t) 'yes) "
+         "((()) 'empty) (else 'other)))",
+         std::nullopt},
+        {"(map kind (list 1 3 20 'a #t '() 4 2.5 \"s\"))",
+         "(small small big sym yes empty other other other)"},
+        {"(case 'x ((y) 1))", "()"},
+        {"(case 5 ((1) 'one) ((5 1000000) 'far))", "far"},
+        {"(case 1 ((1 1) 'first) ((1) 'second))", "first"},
+        {"(case 2 ((2) => (lambda (x) (* x 10))) (else 0))", "20"},
+        {"(case 7 ((1) 1) (else => -))", "-7"},
+        {"(define (count n acc) (case n ((0) acc) (else (count (- n 1) (+ acc 1)))))",
+         std::nullopt},
+        {"(count 100000 0)", "100000"},
+        {"(case 9007199254740993 ((9007199254740992) 'wrong) (else 'right))", "right"},
+        {"(case 2.0 ((2) 'x) (else 'y))", "y"},
+        {"(case 2 ((2.0) 'x) (else 'y))", "y"},
+        {"(case 2.0 ((1 2.0) 'x) (else 'y))", "x"},
+        {"(case -9223372036854775807 ((9223372036854775807) 'wrong) (else 'right))", "right"},
+        {"(case 100000000000000000000 ((100000000000000000000) 'big) (else 'other))", "big"},
+    }};
+
+TEST(list_test_eval, Case) {
+    ValuePool::instance()->root()->reset();
+    RUN_TEST(extra_test_Case, eval);
+    EXPECT_THROW(eval("(case 1 (else 1) ((1) 2))"), ValueError);
+    EXPECT_THROW(eval("(case 1 ((\"a\") 1))"), ValueError);
+    EXPECT_THROW(eval("(case 1)"), ValueError);
+    ValuePool::dispose();
+}
+
+const rjsj_mini_lisp_test::Cases extra_test_Match{
+    "Match",
+    {
+        {"(define (describe x) (match x (() 'empty) ((0 . _) 'zero-first) (('add a b) (+ a b)) "
+         "((? number? n) (* n 2)) ((a b) (list b a)) ((a . rest) rest) (_ 'other)))",
+         std::nullopt},
+        {"(map describe (list '() '(0 1) '(add 1 2) 5 '(1 2) '(1 2 3) \"s\"))",
+         "(empty zero-first 3 10 (2 1) (2 3) other)"},
+        {"(match '(1 (2 3)) ((a (b c)) (list a b c)))", "(1 2 3)"},
+        {"(match '(x #t \"s\") (('x #t \"s\") 'literals))", "literals"},
+        {"(match 4 ((? number? (? (lambda (n) (> n 3)) n)) n))", "4"},
+        {"(define (len xs) (match xs (() 0) ((_ . rest) (+ 1 (len rest)))))", std::nullopt},
+        {"(len '(a b c))", "3"},
+        {"(define (count n acc) (match n (0 acc) (_ (count (- n 1) (+ acc 1)))))",
+         std::nullopt},
+        {"(count 100000 0)", "100000"},
+        {"(match '(1 . 2) ((a . b) (define c (+ a b)) c))", "3"},
+    }};
+
+TEST(list_test_eval, Match) {
+    ValuePool::instance()->root()->reset();
+    RUN_TEST(extra_test_Match, eval);
+    EXPECT_THROW(eval("(match 1 (2 'two))"), ValueError);
+    EXPECT_THROW(eval("(match '(1 1) ((a a) a))"), ValueError);
+    EXPECT_THROW(eval("(match 1)"), ValueError);
+    ValuePool::dispose();
+}
+
+const rjsj_mini_lisp_test::Cases extra_test_Exact{
+    "Exact",
+    {
+        {"(+ 9223372036854775807 1)", "9223372036854775808"},
+        {"(- -9223372036854775808 1)", "-9223372036854775809"},
+        {"(* 4294967296 4294967296)", "18446744073709551616"},
+        {"(- (+ 9223372036854775807 10) 10)", "9223372036854775807"},
+        {"(define (fact n) (if (= n 0) 1 (* n (fact (- n 1)))))", std::nullopt},
+        {"(fact 25)", "15511210043330985984000000"},
+        {"(quotient (fact 40) (fact 38))", "1560"},
+        {"(remainder (+ (fact 30) 7) (fact 29))", "7"},
+        {"(modulo (- (fact 30)) 1000000007)", "890638534"},
+        {"(expt 3 50)", "717897987691852588770249"},
+        {"(integer? 100000000000000000000000)", "#t"},
+        {"(even? (+ (fact 30) 1))", "#f"},
+        {"(list (exact? 1) (exact? 1.5) (inexact? 1.5) (exact? (fact 30)))", "(#t #f #t #t)"},
+        {"(list (/ 6 3) (exact? (/ 6 3)) (/ 7 2) (exact 4.0) (exact? (inexact 4)))",
+         "(2 #t 3.5 4 #f)"},
+        {"(list (= 1 1.0) (equal? 1 1.0) (eq? 2 2) (equal? (fact 30) (fact 30)))",
+         "(#t #f #t #t)"},
+        {"(list (integer? 2.0) (zero? 0.0000001) (< (fact 30) (fact 31)))", "(#t #f #t)"},
+        {"(= 9007199254740993 9007199254740992.0)", "#f"},
+        {"(list (< 9007199254740992.0 9007199254740993) (= 9007199254740992 9007199254740992.0))",
+         "(#t #t)"},
+        {"(list (= (fact 25) (inexact (fact 25))) (< (fact 25) 1e30) (< -2.5 -2) "
+         "(> -1.5 (- (fact 25))))",
+         "(#f #t #t #t)"},
+    }};
+
+TEST(list_test_eval, Exact) {
+    ValuePool::instance()->root()->reset();
+    RUN_TEST(extra_test_Exact, eval);
+    EXPECT_THROW(eval("(/ 1 0)"), ValueError);
+    EXPECT_THROW(eval("(quotient 1 0)"), ValueError);
+    EXPECT_THROW(eval("(exact 1.5)"), ValueError);
+    ValuePool::dispose();
+}
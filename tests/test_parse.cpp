@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include "error.h"
 #include "parser.h"
 #include "rjsj_test.hpp"
 #include "test_util.h"
@@ -20,3 +21,29 @@ TEST(lisp_test_parse, Lv2) {
 TEST(lisp_test_parse, Lv2Only) {
     RUN_TEST(rjsj_mini_lisp_test_Lv2Only, parse);
 }
+
+TEST(lisp_test_parse, LongList) {
+    std::string input = "(";
+    for (int i = 0; i < 100000; i++) {
+        input += "1 ";
+    }
+    input += ". 2)";
+    const auto output = parse(input);
+    EXPECT_EQ(output.size(), input.size());
+}
+
+TEST(lisp_test_parse, DeepNesting) {
+    const auto nested = [](const size_t depth) {
+        return std::string(depth, '(') + std::string(depth, ')');
+    };
+    EXPECT_EQ(parse(nested(1000)).size(), 2000);
+    // at the default limit the stack of the test runner may run out first, which is an error too
+    EXPECT_THROW(parse(nested(Parser::maxDepth + 1)), SyntaxError);
+    EXPECT_THROW(parse(std::string(50000, '(')), SyntaxError);
+    EXPECT_THROW(parse(std::string(50000, '\'') + "a"), SyntaxError);
+    const auto maxDepth = Parser::maxDepth;
+    Parser::maxDepth = 100;
+    EXPECT_EQ(parse(nested(100)).size(), 200);
+    EXPECT_THROW(parse(nested(101)), SyntaxError);
+    Parser::maxDepth = maxDepth;
+}